@@ -0,0 +1,50 @@
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+
+#include "MappedFile.hpp"
+#include "SymbolTable.hpp"
+#include "Exceptions.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+
+//Static library: many object files and an index of the global symbols they define.
+//All header fields are little-endian 32 bit words:
+//
+//  magic "SSAR" | version | member_count | symbol_count | string_table_size
+//  member_count x (name_offset, data_offset, data_size)   - data_offset from the start of the file
+//  symbol_count x (name_offset, member_index)             - sorted by symbol name
+//  string table                                           - NUL terminated names
+//  member contents                                        - object files as written by the assembler
+//
+//The archive is mapped, symbol lookup is a binary search over the index without touching the members.
+
+class Archive{
+  public:
+    Archive(const std::string& file_name);
+
+    int find_member(const std::string& symbol_name) const;         //-1 if no member defines the symbol
+    std::string member_name(uint32_t member_index) const;
+    std::string member_data(uint32_t member_index) const;
+    uint32_t member_count() const;
+    const std::string& name() const;
+
+    static void create(const std::string& archive_name, const std::vector<std::string>& object_file_names);
+
+  private:
+    uint32_t word(size_t offset) const;
+    const char* string_at(uint32_t name_offset) const;
+
+    MappedFile file;
+    uint32_t members;
+    uint32_t symbols;
+    uint32_t string_table_size;
+    size_t members_offset;
+    size_t symbols_offset;
+    size_t strings_offset;
+};
+
+
+#endif
@@ -60,6 +60,9 @@ enum class Instruction {
     NOT, AND, OR, XOR, SHL, SHR,
     LD, ST,
     CSRRD, CSRWR,
+    CAS, FENCE,
+    TLBFLUSH,
+    WAIT,
     NONE
 };
 
@@ -94,6 +97,10 @@ std::unordered_map<Instruction, unsigned char> instruction_op_codes = {
   {Instruction::ST, 0x80},
   {Instruction::CSRRD, 0x90},
   {Instruction::CSRWR, 0x94},
+  {Instruction::CAS, 0xA0},
+  {Instruction::FENCE, 0xA1},
+  {Instruction::TLBFLUSH, 0xA2},
+  {Instruction::WAIT, 0xA3},
 
 };
 
@@ -125,6 +132,10 @@ std::unordered_map<Instruction, uint32_t> instruction_sizes = {
   {Instruction::ST, 4 + 4},        //uses operand
   {Instruction::CSRRD, 2},
   {Instruction::CSRWR, 2},
+  {Instruction::CAS, 3},
+  {Instruction::FENCE, 1},
+  {Instruction::TLBFLUSH, 1},
+  {Instruction::WAIT, 1},
 
 };
 
@@ -0,0 +1,58 @@
+#ifndef _BLOCK_DEVICE_H_
+#define _BLOCK_DEVICE_H_
+
+#include "Device.hpp"
+#include "Memory.hpp"
+#include "MappedFile.hpp"
+#include <mutex>
+
+
+//Block device registers at 0xFFFFFF20, backed by a host file mapped shared, so guest writes reach the file:
+//  +0   sector    first sector of the transfer
+//  +4   count     number of sectors
+//  +8   address   guest physical address of the buffer
+//  +12  command   write 1 -> read sectors into memory, 2 -> write memory to sectors
+//  +16  status    read -> 0 done, 1 error (sectors outside the disk, buffer in denied memory)
+//  +20  sectors   read -> size of the disk in sectors
+//
+//Sectors are 512 bytes. A transfer runs as DMA when the command is written: whole runs of bytes are copied
+//between the mapping and guest pages, no instructions are emulated. The buffer is checked before anything
+//is copied. Completion raises cause 8 on the core that wrote the command, the same for errors.
+//The file is an input of the run like the image, replay needs the same contents.
+class BlockDevice : public Device{
+  public:
+    static const uint32_t base = 0xFFFFFF20;
+    static const uint32_t size = 24;
+    static const uint32_t sector_size = 512;
+    static const int cause = 8;
+
+    BlockDevice(const std::string& file_name, Memory& memory, Interrupt_line interrupt_line);
+
+    uint32_t read(uint32_t core_id, uint32_t offset) override;
+    void write(uint32_t core_id, uint32_t offset, uint32_t value) override;
+
+    void save_state(uint32_t base, Device_state& state) override;
+    void restore_state(uint32_t offset, uint32_t value) override;
+
+  private:
+    enum Command : uint32_t {
+      READ = 1,
+      WRITE = 2
+    };
+
+    bool transfer(uint32_t command);          //false on error
+
+    MappedFile file;
+    Memory& memory;
+    Interrupt_line interrupt_line;
+    uint32_t sectors;
+
+    std::mutex register_mutex;
+    uint32_t sector = 0;
+    uint32_t count = 0;
+    uint32_t address = 0;
+    uint32_t status = 0;
+};
+
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _DEVICE_H_
+#define _DEVICE_H_
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <utility>
+
+
+//Raises interrupt cause on a core
+typedef std::function<void(uint32_t core_id, int interrupt_cause)> Interrupt_line;
+
+
+//Device register values for snapshots, keyed by register address
+typedef std::vector<std::pair<uint32_t, uint32_t>> Device_state;
+
+
+//Memory mapped device. Registers are 32 bit words in the MMIO window, accessed by 32 bit loads and stores.
+//Devices are shared by all cores and must handle concurrent access themselves.
+class Device{
+  public:
+    virtual ~Device(){}
+
+    virtual uint32_t read(uint32_t core_id, uint32_t offset) = 0;             //offset from the device base
+    virtual void write(uint32_t core_id, uint32_t offset, uint32_t value) = 0;
+
+    //Snapshot state, devices without state beyond their registers' side effects save nothing
+    virtual void save_state(uint32_t /*base*/, Device_state& /*state*/){}
+    virtual void restore_state(uint32_t /*offset*/, uint32_t /*value*/){}
+};
+
+
+//Routes MMIO window accesses to devices. Addresses no device claims behave as plain memory.
+class Bus{
+  public:
+    static const uint32_t mmio_base = 0xFFFFFF00;
+
+    void attach(uint32_t base, uint32_t size, Device* device);
+    Device* find(uint32_t address, uint32_t& offset) const;       //nullptr if not claimed
+
+    void save_state(Device_state& state) const;
+    void restore_state(uint32_t address, uint32_t value) const;   //ignored if no device claims the address
+
+  private:
+    struct Mapping{
+      uint32_t base;
+      uint32_t size;
+      Device* device;
+    };
+
+    std::vector<Mapping> mappings;
+};
+
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _DMA_CONTROLLER_H_
+#define _DMA_CONTROLLER_H_
+
+#include "Device.hpp"
+#include "Memory.hpp"
+#include <mutex>
+
+
+//Charges virtual cycles to a core, called on the thread of that core
+typedef std::function<void(uint32_t core_id, uint64_t cycles)> Cycle_line;
+
+
+//DMA controller registers at 0xFFFFFF40:
+//  +0   source        guest physical address, for fill the low byte is the fill value
+//  +4   destination   guest physical address
+//  +8   length        bytes
+//  +12  mode          write 1 -> copy (overlapping ranges copy like memmove), 2 -> fill
+//  +16  status        read -> 0 done, 1 error (bad mode, range in denied memory or wrapping around)
+//
+//The transfer runs on the host when mode is written, with memcpy/memset a page at a time, and the core
+//that wrote mode is charged cycles_per_word virtual cycles per started word. Both ranges are checked before
+//anything is written. Completion raises cause 9 on that core, the same for errors.
+class DmaController : public Device{
+  public:
+    static const uint32_t base = 0xFFFFFF40;
+    static const uint32_t size = 20;
+    static const int cause = 9;
+
+    DmaController(Memory& memory, uint32_t cycles_per_word, Interrupt_line interrupt_line, Cycle_line cycle_line);
+
+    uint32_t read(uint32_t core_id, uint32_t offset) override;
+    void write(uint32_t core_id, uint32_t offset, uint32_t value) override;
+
+    void save_state(uint32_t base, Device_state& state) override;
+    void restore_state(uint32_t offset, uint32_t value) override;
+
+  private:
+    enum Mode : uint32_t {
+      COPY = 1,
+      FILL = 2
+    };
+
+    bool transfer(uint32_t mode);             //false on error
+    void copy_chunk(uint32_t source, uint32_t destination, uint32_t bytes);
+
+    Memory& memory;
+    uint32_t cycles_per_word;
+    Interrupt_line interrupt_line;
+    Cycle_line cycle_line;
+
+    std::mutex register_mutex;
+    uint32_t source = 0;
+    uint32_t destination = 0;
+    uint32_t length = 0;
+    uint32_t status = 0;
+};
+
+
+#endif
@@ -2,6 +2,23 @@
 #define _EMULATOR_H_
 
 #include "Exceptions.hpp"
+#include "Memory.hpp"
+#include "Mmu.hpp"
+#include "InterruptController.hpp"
+#include "Timer.hpp"
+#include "HostCall.hpp"
+#include "Terminal.hpp"
+#include "BlockDevice.hpp"
+#include "DmaController.hpp"
+#include "Image.hpp"
+#include "OutputWriter.hpp"
+#include "Journal.hpp"
+#include "Device.hpp"
+#include "SmpController.hpp"
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+#include "Sampler.hpp"
+#include "InstructionMix.hpp"
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -10,7 +27,12 @@
 #include <regex>
 #include <unordered_map>
 #include <unordered_set>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include <cmath>
+#include <chrono>
 
 
 
@@ -28,6 +50,9 @@ enum class Instruction {
     NOT, AND, OR, XOR, SHL, SHR,
     LD, ST,
     CSRRD, CSRWR,
+    CAS, FENCE,
+    TLBFLUSH,
+    WAIT,
     NONE
 };
 
@@ -57,7 +82,11 @@ std::unordered_map<Instruction, std::string> Instruction_name = {
     { Instruction::LD, "LD" },
     { Instruction::ST, "ST" },
     { Instruction::CSRRD, "CSRRD" },
-    { Instruction::CSRWR, "CSRWR" }
+    { Instruction::CSRWR, "CSRWR" },
+    { Instruction::CAS, "CAS" },
+    { Instruction::FENCE, "FENCE" },
+    { Instruction::TLBFLUSH, "TLBFLUSH" },
+    { Instruction::WAIT, "WAIT" }
 };
 
 
@@ -106,23 +135,119 @@ std::unordered_map<unsigned char, Instruction> instruction_op_codes = {
   {0x90, Instruction::CSRRD},
   {0x94, Instruction::CSRWR},
 
+  {0xA0, Instruction::CAS},
+  {0xA1, Instruction::FENCE},
+  {0xA2, Instruction::TLBFLUSH},
+  {0xA3, Instruction::WAIT},
+
+};
+
+
+//Virtual cycles per instruction for the cycle CSR, op codes not listed take one cycle.
+//A model of relative cost, memory accesses and long operations cost more
+std::unordered_map<unsigned char, uint32_t> op_code_cycles = {
+  {0x10, 4},      //int: two pushes and a jump
+  {0x20, 3},      //call: push, pool word
+  {0x21, 4},      //call over memory
+  {0x34, 3},      //iret: two pops
+  {0x3C, 2},      //ret
+  {0x81, 2},      //push
+  {0x93, 2},      //pop
+  {0x52, 3},      //mul
+  {0x53, 10},     //div
+  {0x92, 2},      //ld from memory
+  {0x80, 2},      //st to memory
+  {0x82, 3},      //st through memory
+  {0xA0, 4},      //cas
+  {0xA1, 2},      //fence
+  {0xA2, 2},      //tlbflush
 };
 
 
+//Keys of machine state words stored in a snapshot (PagedImage state)
+//Memory mapped registers live in guest memory and are saved with the pages, device state under its register address
+enum Snapshot_key : uint32_t {
+    SNAPSHOT_R0 = 0,                  //r0 - r15 -> keys 0 - 15
+    SNAPSHOT_STATUS = 16,
+    SNAPSHOT_HANDLE = 17,
+    SNAPSHOT_CAUSE = 18,
+    SNAPSHOT_ICOUNT_LOW = 19,
+    SNAPSHOT_ICOUNT_HIGH = 20,
+    SNAPSHOT_CYCLE_LOW = 21,
+    SNAPSHOT_CYCLE_HIGH = 22,
+    SNAPSHOT_PTBR = 23,
+    SNAPSHOT_FAULT_ADDRESS = 24,
+    SNAPSHOT_VECTOR_BASE = 25,
+    SNAPSHOT_TIMER_CONFIG = 26,
+    SNAPSHOT_TIMER_DEADLINE_LOW = 27,
+    SNAPSHOT_TIMER_DEADLINE_HIGH = 28
+};
+
+
+//Command line options of the emulator
+struct Emulator_options{
+    std::string restore_file_name;        //start from a snapshot instead of the program
+    std::string snapshot_file_name = "emulator.snapshot";
+    bool snapshot_option = false;
+    bool snapshot_at_pc = false;          //else at instruction count
+    uint32_t snapshot_pc = 0;
+    uint64_t snapshot_icount = 0;
+    std::string record_file_name;         //journal of nondeterministic inputs
+    std::string replay_file_name;
+    bool trace_option = false;            //per instruction state dump to emulator.log
+    uint32_t core_count = 1;
+    std::string fleet_file_name;          //manifest of independent jobs
+    std::string summary_file_name = "fleet.summary";
+    unsigned thread_count = 0;            //fleet workers, 0 -> number of hardware threads
+    std::string profile_prefix;           //instrumentation profile output files
+    std::string sample_prefix;            //sampling profile output files
+    uint32_t sample_interval = 1000;      //usec of host cpu time between samples
+    std::string map_file_name;            //linker symbol map for the profiles
+    bool protect_option = false;          //page permissions, missing pages fault
+    uint32_t stack_pages = 16;            //read/write pages below the memory mapped registers
+    std::string mix_prefix = "instruction_mix";   //instruction mix output files, INSTRUCTION_MIX builds
+    bool unbuffered_terminal = false;     //write every terminal character to the host at once
+    std::string disk_file_name;           //block device backing file
+    uint32_t dma_cycles_per_word = 1;     //virtual cycles a DMA transfer costs per word
+};
+
+
+//One emulator per guest core. Cores share memory and devices, everything else is per core.
 class Emulator{
     public:
-        Emulator();
+        Emulator(Emulator_options options, Memory& memory, Bus& bus, uint32_t core_id = 0);
         ~Emulator();
 
-        void Emulate(std::ifstream& inputFile);
+        void load(const Image& image);                //once, on core 0
+        void run();
+        void write_output(std::ostream& os);
+        void request_interrupt(int interrupt_cause);   //any thread
+        void charge_cycles(uint64_t cycles);          //on the thread of this core, work done by devices for it
+        void attach_timer(Timer* timer);              //before load, on the core the timer interrupts
+        void attach_terminal(Terminal* terminal);     //before load, on the core that polls its buffer
+        void attach_smp(SmpController* smp);          //before run, on every core of a run
+
+        uint64_t get_instruction_count() const;
+        bool exited() const;                          //stopped by the exit host call
+        int get_exit_status() const;
+        const int* get_registers() const;
 
     private:
-        void init_memory(std::ifstream& inputFile);
+        void save_snapshot();
         void execute();
-        void write_output(std::ostream& os);
         void interrupt_check();
+        void wait_for_interrupt();
+        void host_call(uint32_t call);
+        void check_guest_buffer(uint32_t address, uint32_t size, Mmu::Access access);
+        void trap(int trap_cause);
+        void track_call(uint32_t target);
+        void track_return();
+        uint32_t input(Journal_source source, uint32_t live_value);
+        void finish_journal();
+        uint32_t read_counter(int csr);
 
         void inc_pc();
+        unsigned char fetch_byte(int address);
         unsigned char read_memory_byte(int address);
         uint32_t read_memory_32(int address);
         void write_memory_byte(int address, unsigned char value);
@@ -131,6 +256,8 @@ class Emulator{
         void pop(int& val);
 
         std::unordered_map<Instruction, std::function<void(unsigned char op_code)>> instruction_handlers;
+        std::function<void(unsigned char op_code)>* op_code_handlers[256];      //into instruction_handlers
+        bool block_ends[256];                                                   //control transfers and csrwr
         static std::ofstream log_file;
         
         //r[15] -> pc,  r[14] -> sp
@@ -139,8 +266,39 @@ class Emulator{
         int handle = 0;
         int cause = 0;      
         int psw;
-        std::map<int, unsigned char> memory;
+        Memory& memory;
+        Mmu mmu;
+        uint32_t fault_address = 0;
+        uint32_t vector_base = 0;                     //ivt csr, 0 - every cause goes to handle
+        Bus& bus;
+        uint32_t core_id;
+        std::unique_ptr<MappedFile> image_view;       //private view of the image pages
+        uint64_t instruction_count = 0;
+        uint64_t cycle_count = 0;                     //virtual cycles, op_code_cycles
+        uint8_t cycle_costs[256];
+        uint32_t counter_high[3] = {0};               //instreth, cycleh, timeh latched by reading the low word
+        std::chrono::steady_clock::time_point start_time;
         int start_address = 0x40000000;
+
+        Emulator_options options;
+        bool snapshot_taken = false;
+
+        std::unique_ptr<Journal> journal;
+        std::unique_ptr<Profiler> profiler;
+        std::unique_ptr<Sampler> sampler;
+#ifdef INSTRUCTION_MIX
+        std::unique_ptr<InstructionMix> instruction_mix;
+#endif
+        InterruptController interrupts;
+        Timer* timer = nullptr;
+        Terminal* terminal = nullptr;
+        SmpController* smp = nullptr;
+        HostCall host;
+        bool exit_requested = false;
+        int exit_status = 0;
+        static const uint32_t interrupt_interval = 64;    //instructions between checks inside a basic block
+        uint32_t interrupt_countdown = interrupt_interval;
+        uint32_t check_interval = interrupt_interval;      //1 on replay, the journal names exact instructions
                             
 
 };
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <exception>
+#include <cstdint>
 
 
 class InvalidArguments : public std::exception {
@@ -25,7 +26,7 @@ private:
 
 public:
     explicit InvalidLinkerCmdArgs(const std::string& token)
-        : error_message("Usage: " + token + "-hex -place=section@address -o output.hex input1.o input2.o") {}
+        : error_message("Usage: " + token + "-hex|-binary [--icf] [--incremental=state_file] [--no-log] [--threads=N] [--map=file] -place=section@address -o output.hex input1.o input2.o library.a") {}
 
     const char* what() const noexcept override {
         return error_message.c_str();
@@ -38,7 +39,20 @@ private:
 
 public:
     explicit InvalidEmulatorCmdArgs()
-        : error_message("Usage: ./emulator mem_content.hex") {}
+        : error_message("Usage: ./emulator [--snapshot-at=pc:address|icount:count] [--snapshot=file] [--record=journal|--replay=journal] [--trace] [--unbuffered-terminal] [--disk=file] [--dma-cost=N] [--protect] [--stack-pages=N] [--profile=prefix] [--sample=prefix [--sample-interval=usec]] [--map=file] [--cores=N] mem_content.hex|image.bin | --restore=snapshot_file | --fleet=manifest [--summary=file] [--threads=N]") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+class InvalidArchiverCmdArgs : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit InvalidArchiverCmdArgs()
+        : error_message("Usage: ./archiver -o library.a input1.o input2.o") {}
 
     const char* what() const noexcept override {
         return error_message.c_str();
@@ -59,6 +73,104 @@ public:
 };
 
 
+class InvalidArchiveError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit InvalidArchiveError(const std::string& filename)
+        : error_message("File error: \"" + filename + "\" is not a valid library archive or object file") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class InvalidImageError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit InvalidImageError(const std::string& filename)
+        : error_message("File error: \"" + filename + "\" is not a valid memory image") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class InvalidJournalError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit InvalidJournalError(const std::string& filename)
+        : error_message("File error: \"" + filename + "\" is not a valid emulator journal") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class ReplayDivergenceError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit ReplayDivergenceError(const std::string& reason)
+        : error_message("Replay error: run diverged from the journal, " + reason) {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class WaitDeadlockError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit WaitDeadlockError(const uint32_t core_id, const uint32_t pc)
+        : error_message("Emulator error: core " + std::to_string(core_id) + " waits at the address " + std::to_string(pc) + " for an interrupt nothing can raise") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class InvalidFleetManifest : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit InvalidFleetManifest(const std::string& filename, const std::string& line)
+        : error_message("Fleet manifest error in \"" + filename + "\": " + line + "\nExpected: job_name image_file [--replay=journal]") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
+class OutputWriteError : public std::exception {
+private:
+    std::string error_message;
+
+public:
+    explicit OutputWriteError()
+        : error_message("File error: output file could not be written") {}
+
+    const char* what() const noexcept override {
+        return error_message.c_str();
+    }
+};
+
+
 class UnknownToken : public std::exception {
 private:
     std::string error_message;
@@ -320,26 +432,50 @@ public:
 };
 
 
-class MemoryReadViolation : public std::exception {
-private:
+//Guest memory access denied by page permissions, raised as a guest fault by the emulator
+class MemoryAccessViolation : public std::exception {
+protected:
     std::string error_message;
 
 public:
-    explicit MemoryReadViolation(const int address)
-        : error_message("Adress violation! Could not read from the address: " + std::to_string(address)) {}
+    uint32_t address;
+
+    explicit MemoryAccessViolation(const std::string& access, const uint32_t address)
+        : error_message("Adress violation! Could not " + access + " the address: " + std::to_string(address)), address(address) {}
 
     const char* what() const noexcept override {
         return error_message.c_str();
     }
 };
 
-class MemoryWriteViolation : public std::exception {
+class MemoryReadViolation : public MemoryAccessViolation {
+public:
+    explicit MemoryReadViolation(const uint32_t address)
+        : MemoryAccessViolation("read from", address) {}
+};
+
+class MemoryWriteViolation : public MemoryAccessViolation {
+public:
+    explicit MemoryWriteViolation(const uint32_t address)
+        : MemoryAccessViolation("write to", address) {}
+};
+
+class MemoryExecuteViolation : public MemoryAccessViolation {
+public:
+    explicit MemoryExecuteViolation(const uint32_t address)
+        : MemoryAccessViolation("execute from", address) {}
+};
+
+//Guest virtual address without a permitted translation, raised as a page fault by the emulator
+class PageFault : public std::exception {
 private:
     std::string error_message;
 
 public:
-    explicit MemoryWriteViolation(const int address)
-        : error_message("Adress violation! Could not write to the address: " + std::to_string(address)) {}
+    uint32_t address;
+
+    explicit PageFault(const uint32_t address)
+        : error_message("Page fault at the address: " + std::to_string(address)), address(address) {}
 
     const char* what() const noexcept override {
         return error_message.c_str();
@@ -0,0 +1,52 @@
+#ifndef _HOST_CALL_H_
+#define _HOST_CALL_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+//Semihosting: the guest asks the host for bulk I/O with csrwr %gpr, %hostcall. gpr is the call,
+//arguments are in r1, r2, r3 and the result goes to r1:
+//
+//  1 open    r1 path (NUL terminated), r2 mode: 0 read, 1 write, 2 append    -> handle, -1 on error
+//  2 close   r1 handle                                                       -> 0, -1 on error
+//  3 read    r1 handle, r2 buffer, r3 size                                   -> bytes read, -1 on error
+//  4 write   r1 handle, r2 buffer, r3 size                                   -> bytes written, -1 on error
+//  5 time    host microseconds since the run started                         -> r1 low, r2 high word
+//  6 exit    r1 status                                  the core stops like halt, the emulator exits with status
+//
+//Handles 0, 1 and 2 are the emulator's stdin, stdout and stderr. Buffers are copied straight from and to
+//guest pages, a page at a time. Files belong to one core and are closed when it is destroyed.
+class HostCall{
+  public:
+    enum Call : uint32_t {
+      OPEN = 1,
+      CLOSE = 2,
+      READ = 3,
+      WRITE = 4,
+      TIME = 5,
+      EXIT = 6
+    };
+
+    HostCall();
+    ~HostCall();
+
+    HostCall(const HostCall&) = delete;
+    HostCall& operator=(const HostCall&) = delete;
+
+    int open(const std::string& path, uint32_t mode);
+    int close(int handle);
+    int read(int handle, uint8_t* buffer, uint32_t size);
+    int write(int handle, const uint8_t* data, uint32_t size);
+    void flush();
+
+  private:
+    FILE* file(int handle) const;         //nullptr if not open
+
+    std::vector<FILE*> files;
+};
+
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#include "Exceptions.hpp"
+#include "MappedFile.hpp"
+#include "PagedImage.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <fstream>
+#include <sstream>
+
+
+//Program image parsed once: hex text from the linker, or a paged image (linker -binary output, snapshot).
+//Pages are read-only, many emulator instances can share them and copy a page only on their first write to it.
+//
+//Where the host allows it pages live in a host file: the image file itself for paged images, an anonymous
+//memory file (memfd) for parsed hex. Every instance then maps its own private view, the host shares the
+//physical pages between all views (and, for image files, between processes) and copies a page when a view
+//writes to it.
+class Image{
+  public:
+    Image(const std::string& file_name);
+    ~Image();
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    const std::map<uint32_t, const uint8_t*>& pages() const;             //page number -> page_size bytes
+    const std::vector<std::pair<uint32_t, uint32_t>>& state() const;     //machine state words, snapshots only
+    const std::string& name() const;
+
+    //Private copy-on-write view of all pages, nullptr without a host file. Page offsets are the same in every view.
+    std::unique_ptr<MappedFile> private_view() const;
+    const std::map<uint32_t, size_t>& page_offsets() const;
+
+  private:
+    void parse_hex(std::istream& input_file);
+    void parse_paged();
+    void move_hex_pages_to_host_file();
+
+    std::string file_name;
+    std::unique_ptr<MappedFile> file;
+    std::map<uint32_t, std::vector<uint8_t>> hex_pages;
+    std::map<uint32_t, const uint8_t*> page_map;
+    std::map<uint32_t, size_t> page_offset_map;
+    std::vector<std::pair<uint32_t, uint32_t>> state_words;
+    int host_fd = -1;
+    size_t host_size = 0;
+};
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _INSTRUCTION_MIX_H_
+#define _INSTRUCTION_MIX_H_
+
+#include "Exceptions.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+
+//Instruction mix of a run: counts of op codes (every addressing variant has its own op code),
+//of consecutive op code pairs and of triples. Used by the emulator built with INSTRUCTION_MIX.
+//
+//Op codes get dense 6 bit indexes, the last three form the index of a triple counter, so an
+//instruction costs one increment. Op code and pair counts are sums over the triples.
+//Index 0 stands for "before the first instruction".
+//
+//Output files:
+//  prefix.csv     kind,op_codes,instructions,count,percent
+//  prefix.json    the same tables as arrays of objects
+class InstructionMix{
+  public:
+    InstructionMix(const std::map<uint8_t, std::string>& op_code_names);
+
+    void record(uint8_t op_code){
+      this->history = ((this->history << index_bits) | this->op_code_index[op_code]) & triple_mask;
+      this->triple_counts[this->history]++;
+    }
+
+    void write(const std::string& prefix) const;
+
+  private:
+    struct Sequence{
+      std::vector<uint8_t> op_codes;
+      uint64_t count;
+    };
+
+    std::vector<Sequence> sequences(int length) const;      //sorted by count
+
+    static const int index_bits = 6;
+    static const uint32_t index_mask = (1u << index_bits) - 1;
+    static const uint32_t triple_mask = (1u << 3 * index_bits) - 1;
+
+    std::map<uint8_t, std::string> op_code_names;
+    uint8_t op_code_index[256] = {0};         //unknown op codes stop the run, they share index 0
+    std::vector<uint8_t> index_op_code;
+    std::vector<uint64_t> triple_counts;
+    uint32_t history = 0;
+};
+
+
+#endif
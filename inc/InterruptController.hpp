@@ -0,0 +1,39 @@
+#ifndef _INTERRUPT_CONTROLLER_H_
+#define _INTERRUPT_CONTROLLER_H_
+
+#include <cstdint>
+#include <atomic>
+
+
+//Pending interrupts of one core, a bit per cause. Devices, other cores and host threads raise causes
+//atomically from any thread, only the owning core takes them.
+//
+//Masking comes from status: Tr(0) masks the timer (cause 2), Tl(1) the terminal (cause 3), I(2) all causes.
+//Of the unmasked pending causes the lowest cause number has the highest priority.
+//
+//Bit 31 is not a cause, it asks the core for attention (sampler timer). The core polls one word, nonzero
+//means something pending, so polling costs one relaxed load when nothing is.
+class InterruptController{
+  public:
+    static const uint32_t attention = 1u << 31;
+
+    void raise(int cause){
+      this->pending.fetch_or(1u << cause, std::memory_order_release);
+    }
+    bool any() const{
+      return this->pending.load(std::memory_order_relaxed) != 0;
+    }
+
+    bool take_attention();                    //clears the attention bit
+    int take(int status);                     //highest priority unmasked cause, cleared, -1 if none
+
+    std::atomic<uint32_t>& word();            //for raising attention from a signal handler
+
+  private:
+    static uint32_t enabled(int status);
+
+    std::atomic<uint32_t> pending{0};
+};
+
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include "Exceptions.hpp"
+#include "OutputWriter.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <string>
+#include <memory>
+
+
+//Nondeterministic inputs of an emulator run. Everything else is a function of the memory image,
+//so replaying these at the same instruction counts reproduces the run exactly.
+enum class Journal_event : uint32_t {
+    INTERRUPT = 1,        //value: cause, delivered before the instruction with this count
+    INPUT = 2,            //value: input read from source (terminal byte, timer value...)
+    HALT = 3              //value: pc, end of the run - checked on replay
+};
+
+//Sources of INPUT events
+enum Journal_source : uint32_t {
+    JOURNAL_TERMINAL = 1,
+    JOURNAL_TIMER = 2,
+    JOURNAL_WAIT = 3,         //virtual cycles skipped by wait
+    JOURNAL_HOST_CALL = 4     //host call results and read data
+};
+
+struct Journal_entry{
+    Journal_event event;
+    uint64_t instruction_count;
+    uint32_t source;
+    uint32_t value;
+};
+
+
+//Journal file, all fields are little-endian 32 bit words:
+//
+//  magic "SSJR" | version
+//  entries x (event, instruction_count low, instruction_count high, source, value)
+//
+//A journal is either written (record) or read (replay), entries are in instruction count order.
+class Journal{
+  public:
+    enum class Mode { RECORD, REPLAY };
+
+    Journal(const std::string& file_name, Mode mode);
+
+    void record(const Journal_entry& entry);
+    const Journal_entry* peek() const;        //next entry on replay, nullptr at the end
+    Journal_entry next();
+    void close();
+
+    Mode mode() const;
+
+  private:
+    void read_entry();
+
+    Mode journal_mode;
+    std::unique_ptr<OutputWriter> output_file;
+    std::unique_ptr<MappedFile> input_file;
+    size_t read_offset = 0;
+    Journal_entry next_entry;
+    bool has_next = false;
+
+    static const size_t header_words = 2;
+    static const size_t entry_words = 5;
+};
+
+
+#endif
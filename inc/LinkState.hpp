@@ -0,0 +1,48 @@
+#ifndef _LINK_STATE_H_
+#define _LINK_STATE_H_
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+
+//Layout of the previous link, used by incremental linking to patch the existing output file
+struct Link_state{
+
+  //Place of one input section in memory and in the output file
+  struct Section_slot{
+    std::string file_name;
+    std::string section_name;
+    uint32_t location;
+    uint32_t size;               //size of the slot, sections may shrink but never grow
+    uint64_t output_offset;      //offset of the first section byte in the output file
+  };
+
+  //Relocation that uses a symbol defined in another object file
+  struct Import_site{
+    std::string file_name;
+    std::string section_name;
+    uint32_t location;
+    std::string symbol_name;
+  };
+
+  std::string output_file_name;
+  std::string output_format;                                    //hex, binary or none
+  std::vector<std::string> input_file_names;
+  std::map<std::string, uint64_t> section_places;
+  std::map<std::string, uint64_t> object_hashes;                //file_name -> content hash
+  std::vector<Section_slot> sections;
+  std::map<std::string, std::pair<uint32_t, std::string>> symbols;    //symbol_name -> address, defining file
+  std::vector<Import_site> imports;
+
+  bool load(const std::string& file_name);
+  void save(const std::string& file_name) const;
+
+  Section_slot* get_slot(const std::string& file_name, const std::string& section_name);
+};
+
+
+#endif
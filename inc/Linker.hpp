@@ -6,6 +6,10 @@
 #include "RelocationTable.hpp"
 #include "Exceptions.hpp"
 #include "Section.hpp"
+#include "ThreadPool.hpp"
+#include "OutputWriter.hpp"
+#include "LinkState.hpp"
+#include "Archive.hpp"
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -14,7 +18,11 @@
 #include <regex>
 #include <unordered_map>
 #include <unordered_set>
+#include <set>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <memory>
 
 
 enum class ObjectFileReadingType {
@@ -45,22 +53,57 @@ struct Object_file{
 };
 
 
+//Resolved relocation, only the section code still has to be patched
+struct Relocation_patch{
+    uint32_t location;
+    uint32_t value;
+};
+
+
+//Command line options of the linker
+struct Linker_options{
+    bool hex_option = false;
+    bool binary_option = false;       //paged binary image instead of hex
+    bool icf_option = false;          //identical code folding
+    std::string state_file_name;      //incremental linking, empty when disabled
+    std::map<std::string, uint64_t> section_places;
+    std::vector<std::string> library_file_names;      //members are loaded only when they define an undefined symbol
+    bool log_option = true;           //linker.log
+    std::string map_file_name;        //symbol addresses for tools, empty when disabled
+    unsigned thread_count = 0;        //0 -> number of hardware threads
+};
+
+
 class Linker{
     public:
-        Linker(bool hex_option, std::map<std::string, uint64_t> section_places);
+        Linker(Linker_options options);
         ~Linker();
 
         void decompose_input_files(std::vector<std::string> input_file_names);
+        void decompose_object_file(std::string file_name, std::istream& input_file);
         void Link(std::vector<std::string> input_file_names, std::string output_file_name);
 
 
     private:
         void fill_symbol_table();
+        void add_object_symbols(std::string object_file_name);
+        void load_library_members();
         void undefined_symbol_check();
+        void fold_identical_sections();
         void formSections();
         void check_sections_overlapping();
         void resolve_relocations();
-        void write_output_file(std::ofstream& output_file); 
+        void apply_relocations();
+        void write_output_file(OutputWriter& output_file); 
+        void write_binary_output_file(OutputWriter& output_file);
+        void write_symbol_map();
+
+        bool incremental_link(std::vector<std::string> input_file_names, std::string output_file_name);
+        void patch_relinked(const std::vector<std::string>& changed_files, const std::map<std::string, uint32_t>& moved_symbols,
+          Link_state& state, const std::string& patched_file_name);
+        void save_link_state(std::vector<std::string> input_file_names, std::string output_file_name);
+        void patch_output(std::FILE* output_file, const Link_state::Section_slot& slot, size_t index, const std::vector<uint8_t>& bytes);
+        std::string output_format();
 
         uint32_t location_counter = 0;
         static std::ofstream log_file;
@@ -72,11 +115,23 @@ class Linker{
         std::map<std::pair<std::string, std::string>, Section*> output_sections;
         std::vector<std::pair<std::string, std::string>> output_sections_order;
 
+        std::map<Section*, std::vector<Relocation_patch>> relocation_patches;
+
         SymbolTable linker_symbol_table;
         RelocationTable relocation_table;
 
         bool hex_option;
+        bool binary_option;
+        bool icf_option;
+        std::string state_file_name;
         std::map<std::string, uint64_t> section_places;
+        std::map<std::string, uint64_t> requested_section_places;     //section_places before placing consumes them
+        std::vector<std::string> library_file_names;
+        bool log_option;
+        std::string map_file_name;
+        std::map<std::pair<std::string, std::string>, uint64_t> output_offsets;   //section_name, file_name -> offset in output file
+
+        ThreadPool thread_pool;
 
 };
 
@@ -0,0 +1,43 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "Exceptions.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+//View of a whole file mapped into memory. Read-only, copy-on-write where writes stay private
+//to the process and never reach the file, or shared where writes go to the file
+class MappedFile{
+  public:
+    enum Mode{
+      READ_ONLY,
+      COPY_ON_WRITE,
+      SHARED
+    };
+
+    MappedFile(const std::string& file_name, Mode mode = READ_ONLY);
+#ifndef _WIN32
+    MappedFile(int fd, size_t size, const std::string& name, Mode mode);      //fd stays owned by the caller, not SHARED
+#endif
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const;
+    uint8_t* writable_data();                 //nullptr for read-only mappings
+    size_t size() const;
+    const std::string& name() const;
+
+  private:
+    std::string file_name;
+    uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    Mode mode;
+    std::vector<uint8_t> buffer;      //used where mmap is not available, shared buffers are written back when destroyed
+};
+
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include "PagedImage.hpp"
+#include "Exceptions.hpp"
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+
+//Guest memory: 32 bit address space in pages behind a two-level page table (10 + 10 + 12 address bits).
+//Pages can be borrowed from a mapped image or shared read-only with other instances (copied on first write),
+//such pages are not owned by Memory.
+//
+//Every page has read, write and execute permissions, kept in the low bits of its table entry next to
+//the shared mark, so the lookup that finds a page also checks the access. Denied accesses throw
+//MemoryReadViolation, MemoryWriteViolation or MemoryExecuteViolation.
+//Unprotected memory allocates missing pages with all permissions on first write and reads them as 0,
+//protected memory treats missing pages as denied.
+//
+//A core that caches state derived from instructions marks their pages as code pages in the entry. Stores to
+//them leave the fast path and tell the code listeners which bytes changed, stores to other pages
+//never look at code metadata.
+//
+//Memory is shared by all cores. Ordering model:
+//  - page allocation is atomic, a page installed by one core is seen whole by the others
+//  - byte accesses and aligned 32 bit accesses are single-copy atomic and relaxed
+//  - unaligned 32 bit accesses are done byte by byte and may tear
+//  - no ordering between different addresses, guest code orders through cas and fence
+//  - cas on an aligned word is a sequentially consistent host atomic, unaligned cas is not atomic
+//Words are big-endian in guest memory.
+class Memory{
+  public:
+    static const uint32_t page_size = PagedImage::page_size;
+
+    enum Permission : uintptr_t {
+      PAGE_READ = 2,
+      PAGE_WRITE = 4,
+      PAGE_EXECUTE = 8,
+      PAGE_ALL = PAGE_READ | PAGE_WRITE | PAGE_EXECUTE
+    };
+
+    Memory(bool protection = false);
+    ~Memory();
+
+    Memory(const Memory&) = delete;
+    Memory& operator=(const Memory&) = delete;
+
+    uint8_t read_byte(uint32_t address);
+    uint8_t fetch_byte(uint32_t address);                    //instruction fetch, needs execute permission
+    void write_byte(uint32_t address, uint8_t value);
+    uint32_t read_word(uint32_t address);
+    void write_word(uint32_t address, uint32_t value);
+    uint32_t compare_exchange_word(uint32_t address, uint32_t expected, uint32_t desired);     //returns the old value
+
+    //Host copies of guest bytes, address .. address + size - 1 within one page, not atomic
+    const uint8_t* read_span(uint32_t address);                                  //checks read permission
+    void write_span(uint32_t address, const uint8_t* data, uint32_t size);      //checks write permission
+
+    void protect(uint32_t page_number, uintptr_t permissions);    //allocates a zero filled page if missing
+    const uint8_t* find_page(uint32_t page_number) const;     //nullptr if missing
+    void map_page(uint32_t page_number, uint8_t* data, uintptr_t permissions = PAGE_ALL);       //data must outlive Memory
+    void share_page(uint32_t page_number, const uint8_t* data, uintptr_t permissions = PAGE_ALL);   //copied on write, data must outlive Memory
+    std::vector<uint32_t> page_numbers() const;               //present pages, ascending
+
+    typedef std::function<void(uint32_t address, uint32_t size)> Code_listener;
+    void add_code_listener(Code_listener listener);           //before any core runs
+    bool mark_code(uint32_t page_number);                     //false if the page is missing
+
+  private:
+    static const uint32_t table_bits = 10;
+    static const uint32_t table_size = 1 << table_bits;
+    static const uint32_t offset_bits = 12;
+
+    typedef std::atomic<uintptr_t> Page_entry;
+
+    //Entry: page address | code mark | permissions | shared mark, page storage is at least 32 byte aligned
+    static const uintptr_t shared_tag = 1;
+    static const uintptr_t code_tag = 16;
+    static const uintptr_t tag_mask = 31;
+
+    Page_entry* table(uint32_t directory_index);              //allocates if missing
+    uintptr_t entry(uint32_t page_number) const;               //0 if missing
+    uintptr_t writable_entry(uint32_t address);                //allocates or copies, checks write permission
+    void code_written(uint32_t address, uint32_t size);
+    void own_copy(uint32_t page_number, const uint8_t* data, uintptr_t permissions);
+    uint8_t* new_page(const uint8_t* contents);                //page aligned
+    static void free_page(uint8_t* page);
+
+    bool protection;
+
+    std::atomic<Page_entry*> directory[table_size];
+    std::vector<uint8_t*> owned_pages;
+    std::vector<Code_listener> code_listeners;
+    std::mutex owned_pages_mutex;
+};
+
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef _MMU_H_
+#define _MMU_H_
+
+#include "Memory.hpp"
+#include "Exceptions.hpp"
+#include <cstdint>
+
+
+//Paging MMU of one core. Page tables live in guest physical memory, two levels like Memory (10 + 10 + 12 bits):
+//
+//  page table base (ptbr csr)    physical address of the directory, page aligned, 0 turns paging off
+//  directory entry               table physical address (31..12) | valid (0)
+//  table entry                   frame physical address (31..12) | execute (3) | write (2) | read (1) | valid (0)
+//
+//Translations are cached in direct-mapped TLBs, one per access type, filled only with permitted
+//translations, so a hit is one compare. With paging off the TLBs hold identity translations.
+//Missing or denied translations throw PageFault. Writing ptbr and tlbflush empty the TLBs, guest code
+//flushes after changing page tables, other cores are not flushed.
+class Mmu{
+  public:
+    enum Access{
+      READ = 0,
+      WRITE = 1,
+      EXECUTE = 2
+    };
+
+    Mmu(Memory& memory);
+
+    uint32_t translate(uint32_t address, Access access){
+      uint32_t page_number = address >> page_bits;
+      const Tlb_entry& entry = this->tlb[access][page_number & (tlb_size - 1)];
+      if (entry.page_number == page_number) return entry.frame | (address & page_mask);
+
+      return this->walk(address, access);
+    }
+
+    void set_base(uint32_t page_table_base);
+    uint32_t base() const;
+    void flush();
+
+  private:
+    static const uint32_t tlb_size = 64;
+    static const uint32_t page_bits = 12;
+    static const uint32_t page_mask = (1 << page_bits) - 1;
+    static const uint32_t invalid_page = 0xFFFFFFFF;      //page numbers have 20 bits
+
+    struct Tlb_entry{
+      uint32_t page_number;
+      uint32_t frame;
+    };
+
+    uint32_t walk(uint32_t address, Access access);
+
+    Memory& memory;
+    uint32_t page_table_base = 0;
+    Tlb_entry tlb[3][tlb_size];
+};
+
+
+#endif
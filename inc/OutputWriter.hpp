@@ -0,0 +1,48 @@
+#ifndef _OUTPUT_WRITER_H_
+#define _OUTPUT_WRITER_H_
+
+#include "Exceptions.hpp"
+#include "PagedImage.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+
+//Buffered output file. Data is formatted into one large buffer and handed to the OS in big writes,
+//so output speed is bounded by the disk and not by per byte stream formatting
+class OutputWriter{
+  public:
+    OutputWriter(const std::string& file_name, size_t buffer_size = 1 << 20);
+    ~OutputWriter();
+
+    void write_bytes(const void* data, size_t size);
+    void write_word(uint32_t word);                  //little-endian
+    void write_hex(uint32_t location, const std::vector<uint8_t>& code);
+    uint64_t write_paged_image(const std::map<uint32_t, std::vector<uint8_t>>& pages,
+      const std::vector<std::pair<uint32_t, uint32_t>>& state = {});
+    void flush();
+    void close();
+
+    uint64_t offset() const;                        //number of bytes written so far
+
+    static std::string hex_text(uint32_t location, const std::vector<uint8_t>& code);
+    static uint64_t hex_byte_offset(uint32_t location, size_t index);
+
+  private:
+    void reserve(size_t size);
+
+    static size_t format_hex_row(char* out, uint32_t address, const uint8_t* bytes, size_t count);
+    static size_t address_width(uint32_t address);
+
+    std::FILE* file = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t written = 0;
+
+    static const char (&hex_table())[256][3];
+};
+
+
+#endif
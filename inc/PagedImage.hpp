@@ -0,0 +1,26 @@
+#ifndef _PAGED_IMAGE_H_
+#define _PAGED_IMAGE_H_
+
+#include <cstdint>
+
+
+//Binary memory image, written by the linker (-binary) and read by the emulator.
+//All header fields are little-endian 32 bit words:
+//
+//  magic "SSPI" | version | page_size | page_count | state_count
+//  state_count x (key, value)       - machine state words, none in linker output
+//  page_count x page_number         - guest page numbers (address / page_size), ascending
+//  zero padding up to page_size
+//  page_count x page_size bytes     - page contents in the order of the page numbers
+//
+//Page contents start at a page aligned file offset, so the file can be mapped directly.
+
+namespace PagedImage{
+  const char magic[4] = {'S', 'S', 'P', 'I'};
+  const uint32_t version = 1;
+  const uint32_t page_size = 4096;
+  const uint32_t header_words = 5;
+}
+
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include "Exceptions.hpp"
+#include "SymbolMap.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+
+
+//Instrumentation profiler of guest code: execution counts per pc and per opcode, and a call tree
+//built from call/ret and interrupt entry/iret. Counts are attributed to the current call tree node.
+//
+//Output files:
+//  prefix.report    flat profile per function and per pc, opcode counts, call tree
+//  prefix.folded    one line per call path "f1;f2;f3 instructions", input for flamegraph tools
+//
+//Addresses are symbolized with the linker symbol map (linker --map) when one is given.
+class Profiler{
+  public:
+    Profiler(const std::string& prefix, uint32_t entry_address);
+
+    void load_symbols(const std::string& map_file_name);
+
+    void instruction(uint32_t pc, uint8_t op_code){
+      this->pc_counts[pc]++;
+      this->opcode_counts[op_code]++;
+      this->nodes[this->current].instructions++;
+    }
+    void retract(uint32_t pc, uint8_t op_code){          //faulted and restarts, counted again when it retires
+      if (--this->pc_counts[pc] == 0) this->pc_counts.erase(pc);
+      this->opcode_counts[op_code]--;
+      this->nodes[this->current].instructions--;
+    }
+    void call(uint32_t target);
+    void ret();
+
+    void write(const std::map<uint8_t, std::string>& opcode_names);
+
+  private:
+    struct Call_node{
+      uint32_t function;
+      uint32_t parent;
+      uint64_t calls = 0;
+      uint64_t instructions = 0;              //self
+      std::map<uint32_t, uint32_t> children;  //function -> node
+
+      Call_node(uint32_t function, uint32_t parent): function(function), parent(parent){}
+    };
+
+    uint64_t total_instructions(uint32_t node) const;
+    void write_call_tree(std::ostream& os, uint32_t node, int depth) const;
+    void write_folded(std::ostream& os, uint32_t node, const std::string& path) const;
+
+    std::string prefix;
+    std::unordered_map<uint32_t, uint64_t> pc_counts;
+    uint64_t opcode_counts[256] = {0};
+    std::vector<Call_node> nodes;
+    uint32_t current = 0;
+    SymbolMap symbols;
+};
+
+
+#endif
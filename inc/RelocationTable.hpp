@@ -14,6 +14,7 @@
 enum class Usage_type{
   SYMBOL,
   SYMBOL_INDIRECT,
+  SYMBOL_JUMP,          //jump and call targets, resolved like SYMBOL
   NONE
 };
 
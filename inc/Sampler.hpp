@@ -0,0 +1,69 @@
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+#include "Exceptions.hpp"
+#include "SymbolMap.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+
+
+//Sampling profiler of guest code. A host interval timer (SIGPROF) sets an attention bit in the
+//interrupt pending word of the sampled core, the emulator checks that word with interrupts anyway,
+//at the end of every basic block and every interrupt_interval instructions, so the dispatch loop does
+//no extra work between samples.
+//
+//A sample is taken at the next check, at most one block or interval later, so per pc counts gather on
+//block entries (branch targets, return addresses) and on every interval-th instruction of long blocks.
+//Function counts are skewed only by that delay, the pc and the shadow stack are sampled together.
+//
+//Calls, traps and returns keep a shallow shadow stack of function entries (a ring, deep recursion
+//keeps only the innermost frames). A sample is the current pc and the top of that stack.
+//
+//Output files:
+//  prefix.samples   samples per function and per pc
+//  prefix.folded    one line per sampled stack "f1;f2;f3 samples", input for flamegraph tools
+//
+//Timer based, so only one sampler per process.
+class Sampler{
+  public:
+    Sampler(const std::string& prefix, uint32_t interval_usec, uint32_t entry_address,
+      std::atomic<uint32_t>& attention, uint32_t attention_mask);
+    ~Sampler();
+
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    void load_symbols(const std::string& map_file_name);
+
+    void call(uint32_t target){
+      this->frames[this->depth++ % shadow_stack_size] = target;
+    }
+    void ret(){
+      if (this->depth > 1) this->depth--;     //entry frame stays
+    }
+
+    void sample(uint32_t pc);
+    void stop();
+    void write();
+
+    static const uint32_t shadow_stack_size = 64;
+    static const uint32_t backtrace_depth = 16;
+
+  private:
+    std::string prefix;
+    uint32_t frames[shadow_stack_size];
+    uint64_t depth = 0;
+    bool running = false;
+
+    uint64_t samples = 0;
+    std::unordered_map<uint32_t, uint64_t> pc_samples;
+    std::map<std::vector<uint32_t>, uint64_t> stack_samples;    //outermost frame first
+    SymbolMap symbols;
+};
+
+
+#endif
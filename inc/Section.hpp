@@ -23,8 +23,6 @@ public:
 
   friend std::ostream& operator<<(std::ostream& os, const Section& section);
 
-  void hex_output(std::ostream& os);
-
   std::string name;
   std::string file_name;
   std::vector<uint8_t> section_code; 
@@ -32,6 +30,7 @@ public:
   //LINKER
   uint32_t location = 0;
   bool placed = false;
+  Section* folded_into = nullptr;     //identical code folding - section whose copy is used in the output
 };
 
 
@@ -0,0 +1,46 @@
+#ifndef _SMP_CONTROLLER_H_
+#define _SMP_CONTROLLER_H_
+
+#include "Device.hpp"
+#include <atomic>
+#include <memory>
+
+
+//Multi-core registers at 0xFFFFFF80:
+//  +0  ipi       write core id -> inter-processor interrupt (cause 5) on that core
+//  +4  core_id   read -> id of the reading core
+//  +8  cores     read -> number of cores
+//
+//The controller also knows which cores can still send an IPI, so a core waiting for one can tell when
+//none will come: every other core has stopped or is parked in a wait only an interrupt ends.
+class SmpController : public Device{
+  public:
+    static const uint32_t base = 0xFFFFFF80;
+    static const uint32_t size = 12;
+    static const int ipi_cause = 5;
+
+    SmpController(uint32_t core_count, Interrupt_line interrupt_line);
+
+    uint32_t read(uint32_t core_id, uint32_t offset) override;
+    void write(uint32_t core_id, uint32_t offset, uint32_t value) override;
+
+    void park(uint32_t core_id);              //waiting for an interrupt nothing in the core can raise
+    void unpark(uint32_t core_id);            //woken, by an IPI or anything else
+    void stop(uint32_t core_id);              //halted, exited or failed, for good
+    bool any_awake() const;
+
+  private:
+    enum Core_state : uint8_t {
+      AWAKE,
+      PARKED,
+      STOPPED
+    };
+
+    uint32_t core_count;
+    Interrupt_line interrupt_line;
+    std::unique_ptr<std::atomic<uint8_t>[]> core_states;
+    std::atomic<uint32_t> awake_cores;
+};
+
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _SYMBOL_MAP_H_
+#define _SYMBOL_MAP_H_
+
+#include "Exceptions.hpp"
+#include <cstdint>
+#include <string>
+#include <map>
+
+
+//Guest addresses to names, read from a linker symbol map (linker --map): lines "0xADDRESS name file"
+class SymbolMap{
+  public:
+    void load(const std::string& map_file_name);
+
+    std::string symbolize(uint32_t address) const;          //name+0xoffset of the closest symbol below
+    std::string function_name(uint32_t address) const;      //exact symbol, else the address
+    std::string containing_symbol(uint32_t address) const;  //closest symbol below, "?" if none
+
+  private:
+    std::map<uint32_t, std::string> symbols;                //address -> name
+};
+
+
+#endif
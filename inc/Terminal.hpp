@@ -0,0 +1,47 @@
+#ifndef _TERMINAL_H_
+#define _TERMINAL_H_
+
+#include "Device.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+
+//Terminal registers at 0xFFFFFF00:
+//  +0  term_out  write -> character in the low byte goes to the host stdout
+//  +4  term_in   read -> 0, terminal input is not emulated
+//
+//Output is buffered and written to the host in one call when a newline is written, when the buffer is full,
+//when the oldest buffered character is flush_timeout_usec old in virtual time (cycles of the polling core, checked
+//with interrupts) and when the run ends. Unbuffered terminals write and flush every character, for interactive use.
+class Terminal : public Device{
+  public:
+    static const uint32_t base = 0xFFFFFF00;
+    static const uint32_t size = 8;
+    static const size_t buffer_size = 4096;
+    static const uint64_t flush_timeout_usec = 10000;      //virtual, at the timer clock
+
+    Terminal(bool unbuffered);
+    ~Terminal();
+
+    uint32_t read(uint32_t core_id, uint32_t offset) override;
+    void write(uint32_t core_id, uint32_t offset, uint32_t value) override;
+
+    void poll(uint64_t now){
+      if (this->buffered.load(std::memory_order_relaxed)) this->flush_if_old(now);
+    }
+    void flush();
+
+  private:
+    void flush_if_old(uint64_t now);
+    void flush_locked();
+
+    bool unbuffered;
+    std::string buffer;
+    std::mutex buffer_mutex;
+    std::atomic<bool> buffered{false};
+    uint64_t deadline = 0;                  //0 - not seen by a poll yet
+};
+
+
+#endif
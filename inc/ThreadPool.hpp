@@ -0,0 +1,51 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+
+
+//Fixed size pool of worker threads. Tasks are independent, wait() blocks until all submitted tasks are done
+//and rethrows the first exception thrown by any of them.
+//Every worker has its own task queue: tasks submitted from outside are spread over the queues, tasks submitted
+//by a worker go to its own queue. A worker takes the newest task from its queue and, when that is empty,
+//steals the oldest task from another queue, so uneven tasks do not leave workers idle.
+class ThreadPool{
+  public:
+    ThreadPool(unsigned thread_count = 0);      //0 -> number of hardware threads
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait();
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+    unsigned size() const;
+
+  private:
+    struct Worker_queue{
+      std::mutex mutex;
+      std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(unsigned worker);
+    std::function<void()> take_task(unsigned worker);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Worker_queue>> queues;
+    std::mutex mutex;                       //counters below
+    std::condition_variable task_available;
+    std::condition_variable all_done;
+    size_t queued_tasks = 0;                //submitted and not yet taken by a worker
+    size_t unfinished_tasks = 0;
+    unsigned next_queue = 0;
+    bool stopping = false;
+    std::exception_ptr first_exception;
+};
+
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "Device.hpp"
+#include <atomic>
+
+
+//Timer register at 0xFFFFFF10:
+//  +0  tim_cfg   period: 0 - 500ms, 1 - 1s, 2 - 1.5s, 3 - 2s, 4 - 5s, 5 - 10s, 6 - 30s, 7 - 60s
+//
+//The timer runs in virtual time, the cycle count of core 0 at cycles_per_usec, so its interrupts (cause 2
+//on core 0) are deterministic and a waiting core can skip straight to the next deadline.
+//It is stopped until tim_cfg is first written, every write starts a new period at the current time.
+//Periods missed while the core was busy for longer are dropped, one interrupt per deadline reached.
+class Timer : public Device{
+  public:
+    static const uint32_t base = 0xFFFFFF10;
+    static const uint32_t size = 4;
+    static const int cause = 2;
+    static const uint64_t cycles_per_usec = 10;
+    static const uint64_t stopped = ~(uint64_t)0;
+
+    uint32_t read(uint32_t core_id, uint32_t offset) override;
+    void write(uint32_t core_id, uint32_t offset, uint32_t value) override;
+
+    //Core 0, at interrupt checks: expired is the cheap test, tick the rest
+    bool expired(uint64_t now) const{
+      return now >= this->deadline.load(std::memory_order_relaxed);
+    }
+    bool tick(uint64_t now);                  //true if a period ended
+    uint64_t next_deadline() const;           //stopped if not running
+
+    uint32_t config() const;
+    void restore(uint32_t config, uint64_t deadline);     //snapshot state
+
+  private:
+    uint64_t period() const;
+
+    std::atomic<uint32_t> configuration{0};
+    std::atomic<bool> restart{false};
+    std::atomic<uint64_t> deadline{stopped};
+};
+
+
+#endif
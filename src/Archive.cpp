@@ -0,0 +1,170 @@
+#include "../inc/Archive.hpp"
+#include <cstring>
+#include <map>
+
+
+static const char archive_magic[4] = {'S', 'S', 'A', 'R'};
+static const uint32_t archive_version = 1;
+static const size_t header_words = 5;
+
+
+Archive::Archive(const std::string& file_name): file(file_name){
+  if (this->file.size() < header_words * 4 || std::memcmp(this->file.data(), archive_magic, 4) != 0 || this->word(4) != archive_version)
+    throw InvalidArchiveError(file_name);
+
+  this->members = this->word(8);
+  this->symbols = this->word(12);
+  this->string_table_size = this->word(16);
+
+  this->members_offset = header_words * 4;
+  this->symbols_offset = this->members_offset + (size_t)this->members * 12;
+  this->strings_offset = this->symbols_offset + (size_t)this->symbols * 8;
+
+  if (this->strings_offset + this->string_table_size > this->file.size())
+    throw InvalidArchiveError(file_name);
+}
+
+
+uint32_t Archive::word(size_t offset) const{
+  const uint8_t* bytes = this->file.data() + offset;
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+const char* Archive::string_at(uint32_t name_offset) const{
+  return reinterpret_cast<const char*>(this->file.data() + this->strings_offset + name_offset);
+}
+
+
+int Archive::find_member(const std::string& symbol_name) const{
+  uint32_t low = 0, high = this->symbols;
+
+  while (low < high){
+    uint32_t middle = low + (high - low) / 2;
+    size_t entry = this->symbols_offset + (size_t)middle * 8;
+    int compare = std::strcmp(this->string_at(this->word(entry)), symbol_name.c_str());
+
+    if (compare == 0) return this->word(entry + 4);
+    if (compare < 0) low = middle + 1;
+    else high = middle;
+  }
+
+  return -1;
+}
+
+
+std::string Archive::member_name(uint32_t member_index) const{
+  return this->string_at(this->word(this->members_offset + (size_t)member_index * 12));
+}
+
+std::string Archive::member_data(uint32_t member_index) const{
+  size_t entry = this->members_offset + (size_t)member_index * 12;
+  uint32_t data_offset = this->word(entry + 4);
+  uint32_t data_size = this->word(entry + 8);
+
+  if ((size_t)data_offset + data_size > this->file.size())
+    throw InvalidArchiveError(this->file.name());
+
+  return std::string(reinterpret_cast<const char*>(this->file.data() + data_offset), data_size);
+}
+
+uint32_t Archive::member_count() const{
+  return this->members;
+}
+
+const std::string& Archive::name() const{
+  return this->file.name();
+}
+
+
+
+//Global symbols defined by an object file, read from its symbol table
+static std::vector<std::string> defined_global_symbols(const std::string& object_file_name, const std::string& contents){
+  std::vector<std::string> symbol_names;
+  std::istringstream input(contents);
+  std::string line;
+  bool symbol_table = false;
+
+  while (getline(input, line)){
+    if (line.empty() || line.find_first_not_of(' ') == std::string::npos) continue;
+
+    if (line.find("Symbols Table") != std::string::npos){
+      symbol_table = true;
+      getline(input, line);       //remove header
+      continue;
+    }
+    if (line.find("Sections code") != std::string::npos) break;
+    if (!symbol_table) continue;
+
+    Symbol* symbol = Symbol::deserialize_symbol(line);
+    if (symbol->is_global && symbol->defined) symbol_names.push_back(symbol->name);
+    delete symbol;
+  }
+
+  if (!symbol_table)
+    throw InvalidArchiveError(object_file_name);
+
+  return symbol_names;
+}
+
+
+static void put_word(std::ofstream& output_file, uint32_t word){
+  char bytes[4] = {(char)(word & 0xFF), (char)((word >> 8) & 0xFF), (char)((word >> 16) & 0xFF), (char)((word >> 24) & 0xFF)};
+  output_file.write(bytes, 4);
+}
+
+
+void Archive::create(const std::string& archive_name, const std::vector<std::string>& object_file_names){
+  std::vector<std::string> contents;
+  std::string string_table;
+  std::vector<uint32_t> member_name_offsets;
+  std::map<std::string, uint32_t> symbol_index;           //sorted by name, first definition wins
+  std::map<std::string, uint32_t> symbol_name_offsets;
+
+  for (uint32_t i = 0; i < object_file_names.size(); i++){
+    std::ifstream input_file(object_file_names[i], std::ios::binary);
+    if (!input_file.is_open())
+      throw FileNameError(object_file_names[i]);
+
+    std::stringstream data;
+    data << input_file.rdbuf();
+    contents.push_back(data.str());
+
+    std::string member_name = object_file_names[i].substr(object_file_names[i].find_last_of("/\\") + 1);
+    member_name_offsets.push_back(string_table.size());
+    string_table += member_name + '\0';
+
+    for (std::string symbol_name : defined_global_symbols(object_file_names[i], contents.back()))
+      if (symbol_index.insert({symbol_name, i}).second){
+        symbol_name_offsets[symbol_name] = string_table.size();
+        string_table += symbol_name + '\0';
+      }
+  }
+
+  std::ofstream output_file(archive_name, std::ios::binary);
+  if (!output_file.is_open())
+    throw FileNameError(archive_name);
+
+  output_file.write(archive_magic, 4);
+  put_word(output_file, archive_version);
+  put_word(output_file, contents.size());
+  put_word(output_file, symbol_index.size());
+  put_word(output_file, string_table.size());
+
+  uint32_t data_offset = header_words * 4 + contents.size() * 12 + symbol_index.size() * 8 + string_table.size();
+  for (uint32_t i = 0; i < contents.size(); i++){
+    put_word(output_file, member_name_offsets[i]);
+    put_word(output_file, data_offset);
+    put_word(output_file, contents[i].size());
+    data_offset += contents[i].size();
+  }
+
+  for (auto& symbol : symbol_index){
+    put_word(output_file, symbol_name_offsets.at(symbol.first));
+    put_word(output_file, symbol.second);
+  }
+
+  output_file.write(string_table.data(), string_table.size());
+
+  for (auto& member : contents)
+    output_file.write(member.data(), member.size());
+}
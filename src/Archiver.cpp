@@ -0,0 +1,43 @@
+#include "../inc/Archive.hpp"
+#include <regex>
+#include <iostream>
+
+
+int main(int argc, char* argv[]) {
+  try {
+
+    std::regex input_file_regex(R"(^.*\.o$)");
+    std::vector<std::string> input_file_names;
+    std::string output_file_name;
+
+    for(int i = 1; i < argc; i++){
+      std::string token = argv[i];
+
+      //-o
+      if (token == "-o" && i + 1 < argc) {
+        output_file_name = argv[++i];
+        continue;
+      }
+
+      if (std::regex_search(token, input_file_regex)) {
+        input_file_names.push_back(token);
+        continue;
+      }
+
+      throw InvalidArchiverCmdArgs();
+    }
+
+    if (output_file_name.empty() || input_file_names.empty())
+      throw InvalidArchiverCmdArgs();
+
+    Archive::create(output_file_name, input_file_names);
+
+    std::cout<<"Archive created!\n";
+  }
+
+  catch(const std::exception& e) {
+    std::cout << e.what() << '\n';
+  }
+
+  return 0;
+}
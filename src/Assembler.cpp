@@ -15,12 +15,12 @@ std::map<Token_type, std::regex> Assembler::token_parser =
         { Token_type::OPERAND_REG_IND, std::regex(R"(^\[.*\]$)")},
         { Token_type::OPERAND_REG, std::regex("^%r([0-9]{1,2})$")},
         { Token_type::OPERAND_REG_SPEC, std::regex("^%(pc|sp)")},
-        { Token_type::OPERAND_REG_STATUS_CONTROL, std::regex("^%(status|handler|cause)")},
+        { Token_type::OPERAND_REG_STATUS_CONTROL, std::regex("^%(status|handler|cause|instret|instreth|cycle|cycleh|time|timeh|ptbr|faultaddr|ivt|hostcall)$")},
         { Token_type::OPERAND_DECIMAL_INDIRECT, std::regex("^(\\d+)$")},
         { Token_type::OPERAND_HEX_INDIRECT, std::regex("^(0x[0-9a-fA-F]+)$")},
         { Token_type::OPERAND_DECIMAL, std::regex("^\\$(\\d+)$")},
         { Token_type::OPERAND_HEX, std::regex(R"(^\$(0x[0-9a-fA-F]+)$)")},
-        { Token_type::INSTRUCTION, std::regex("^(halt|int|ret|call|iret|jmp|beq|bne|bgt|push|pop|xchg|add|sub|mul|div|not|and|or|xor|shl|shr|ld|st|csrrd|csrwr)(eq|ne|gt|ge|lt|le|al)?(s)?$")},
+        { Token_type::INSTRUCTION, std::regex("^(halt|int|ret|call|iret|jmp|beq|bne|bgt|push|pop|xchg|add|sub|mul|div|not|and|or|xor|shl|shr|ld|st|csrrd|csrwr|cas|fence|tlbflush|wait)(eq|ne|gt|ge|lt|le|al)?(s)?$")},
         { Token_type::LABEL, std::regex("^([a-zA-Z_][a-zA-Z0-9_]*):$")},
         { Token_type::SYMBOL_INDIRECT, std::regex("^\\$([a-zA-Z_][a-zA-Z0-9_]*)$")},
         { Token_type::SYMBOL, std::regex("^([a-zA-Z_][a-zA-Z0-9_]*)$")}
@@ -82,6 +82,10 @@ Instruction Assembler::Enumerate_instruction(const std::string& instruction_name
   if (instruction_name == "st") return Instruction::ST;
   if (instruction_name == "csrrd") return Instruction::CSRRD;
   if (instruction_name == "csrwr") return Instruction::CSRWR;
+  if (instruction_name == "cas") return Instruction::CAS;
+  if (instruction_name == "fence") return Instruction::FENCE;
+  if (instruction_name == "tlbflush") return Instruction::TLBFLUSH;
+  if (instruction_name == "wait") return Instruction::WAIT;
    
   return Instruction::NONE;
 }
@@ -143,7 +147,7 @@ Operand Assembler::get_operand(const Token& token, const Instruction& instructio
 
       //rellocation entry
       int location  = this->sections.at(Assembler::current_section_name).get_writing_location();  
-      relocation_table.add_relocation(new Relocation(token.name, Usage_type::SYMBOL, location + 4, Assembler::current_section_name));
+      relocation_table.add_relocation(new Relocation(token.name, Usage_type::SYMBOL_JUMP, location + 4, Assembler::current_section_name));
 
       return Operand(Address_mode::SYMBOLIC_ADR, 0, offset); 
     }
@@ -1090,6 +1094,46 @@ Assembler::Assembler(){
 
 
 
+      }
+    },
+
+    {Instruction::CAS, [&](std::vector<Token>& tokens){
+        //cas %gprA, %gprB, %gprC
+        //atomic: temp<=mem32[gpr[A]]; if(temp == gpr[B]) mem32[gpr[A]]<=gpr[C]; gpr[B]<=temp
+
+        std::vector<std::unordered_set<Token_type>> expected_params = {reg_type, comma, reg_type, comma, reg_type};
+        if(!this->syntax_param_check(expected_params, tokens)) throw SyntaxError(this->line_counter);
+
+        uint8_t op_code = instruction_op_codes.at(Instruction::CAS);
+        uint8_t gprA = this->reg_num(tokens[0]);
+        uint8_t gprB = this->reg_num(tokens[2]);
+        uint8_t gprC = this->reg_num(tokens[4]);
+        this->sections.at(Assembler::current_section_name).write_instruction((op_code>>4)&0x0F, op_code&0x0F, gprA, gprB, gprC);
+
+      }
+    },
+
+    {Instruction::FENCE, [&](std::vector<Token>& tokens){
+        //FENCE NO_ARGS
+        if(tokens.size()) throw SyntaxError(this->line_counter);
+
+        this->sections.at(Assembler::current_section_name).append_code_byte(instruction_op_codes.at(Instruction::FENCE));
+      }
+    },
+
+    {Instruction::TLBFLUSH, [&](std::vector<Token>& tokens){
+        //TLBFLUSH NO_ARGS
+        if(tokens.size()) throw SyntaxError(this->line_counter);
+
+        this->sections.at(Assembler::current_section_name).append_code_byte(instruction_op_codes.at(Instruction::TLBFLUSH));
+      }
+    },
+
+    {Instruction::WAIT, [&](std::vector<Token>& tokens){
+        //WAIT NO_ARGS
+        if(tokens.size()) throw SyntaxError(this->line_counter);
+
+        this->sections.at(Assembler::current_section_name).append_code_byte(instruction_op_codes.at(Instruction::WAIT));
       }
     }
 
@@ -1141,6 +1185,16 @@ uint8_t Assembler::reg_num(const Token& token){
     if(reg_name == "status") reg_num = 0; 
     else if(reg_name == "handler") reg_num = 1;
     else if(reg_name == "cause") reg_num = 2;
+    else if(reg_name == "instret") reg_num = 3;       //read only counters, low word latches the high word
+    else if(reg_name == "instreth") reg_num = 4;
+    else if(reg_name == "cycle") reg_num = 5;
+    else if(reg_name == "cycleh") reg_num = 6;
+    else if(reg_name == "time") reg_num = 7;
+    else if(reg_name == "timeh") reg_num = 8;
+    else if(reg_name == "ptbr") reg_num = 9;          //page table base, 0 turns paging off
+    else if(reg_name == "faultaddr") reg_num = 10;    //address of the last memory fault
+    else if(reg_name == "ivt") reg_num = 11;          //vector table base, 0 traps to handler
+    else if(reg_name == "hostcall") reg_num = 12;     //write only, runs a host call
   }
   
 
@@ -0,0 +1,89 @@
+#include "../inc/BlockDevice.hpp"
+#include <cstring>
+
+
+BlockDevice::BlockDevice(const std::string& file_name, Memory& memory, Interrupt_line interrupt_line)
+  : file(file_name, MappedFile::SHARED), memory(memory), interrupt_line(interrupt_line){
+  this->sectors = this->file.size() / sector_size;
+}
+
+
+uint32_t BlockDevice::read(uint32_t /*core_id*/, uint32_t offset){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  if (offset == 0) return this->sector;
+  if (offset == 4) return this->count;
+  if (offset == 8) return this->address;
+  if (offset == 16) return this->status;
+  if (offset == 20) return this->sectors;
+  return 0;
+}
+
+void BlockDevice::write(uint32_t core_id, uint32_t offset, uint32_t value){
+  {
+    std::lock_guard<std::mutex> lock(this->register_mutex);
+
+    if (offset == 0) this->sector = value;
+    else if (offset == 4) this->count = value;
+    else if (offset == 8) this->address = value;
+    if (offset != 12) return;
+
+    this->status = this->transfer(value) ? 0 : 1;
+  }
+
+  this->interrupt_line(core_id, cause);
+}
+
+
+//Whole runs within a page at a time, straight between the mapping and the page
+bool BlockDevice::transfer(uint32_t command){
+  if (command != READ && command != WRITE) return false;
+  if ((uint64_t)this->sector + this->count > this->sectors) return false;
+
+  uint64_t bytes = (uint64_t)this->count * sector_size;
+  if (this->address + bytes > ((uint64_t)1 << 32)) return false;
+
+  uint8_t* disk = this->file.writable_data() + (size_t)this->sector * sector_size;
+
+  try{
+    for (uint64_t done = 0; done < bytes; ){
+      uint32_t address = this->address + done;
+      if (command == READ) this->memory.write_span(address, nullptr, 0);
+      else this->memory.read_span(address);
+      done += Memory::page_size - (address & (Memory::page_size - 1));
+    }
+  }
+  catch (const MemoryAccessViolation&){
+    return false;
+  }
+
+  for (uint64_t done = 0; done < bytes; ){
+    uint32_t address = this->address + done;
+    uint32_t chunk = std::min<uint64_t>(bytes - done, Memory::page_size - (address & (Memory::page_size - 1)));
+
+    if (command == READ) this->memory.write_span(address, disk + done, chunk);
+    else std::memcpy(disk + done, this->memory.read_span(address), chunk);
+    done += chunk;
+  }
+
+  return true;
+}
+
+
+void BlockDevice::save_state(uint32_t base, Device_state& state){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  state.push_back({base, this->sector});
+  state.push_back({base + 4, this->count});
+  state.push_back({base + 8, this->address});
+  state.push_back({base + 16, this->status});
+}
+
+void BlockDevice::restore_state(uint32_t offset, uint32_t value){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  if (offset == 0) this->sector = value;
+  else if (offset == 4) this->count = value;
+  else if (offset == 8) this->address = value;
+  else if (offset == 16) this->status = value;
+}
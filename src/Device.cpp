@@ -0,0 +1,29 @@
+#include "../inc/Device.hpp"
+
+
+//Devices are attached before cores start, the mapping list is read-only while running
+void Bus::attach(uint32_t base, uint32_t size, Device* device){
+  this->mappings.push_back({base, size, device});
+}
+
+
+Device* Bus::find(uint32_t address, uint32_t& offset) const{
+  for (const Mapping& mapping : this->mappings)
+    if (address - mapping.base < mapping.size){
+      offset = address - mapping.base;
+      return mapping.device;
+    }
+
+  return nullptr;
+}
+
+
+void Bus::save_state(Device_state& state) const{
+  for (const Mapping& mapping : this->mappings) mapping.device->save_state(mapping.base, state);
+}
+
+void Bus::restore_state(uint32_t address, uint32_t value) const{
+  uint32_t offset;
+  Device* device = this->find(address, offset);
+  if (device != nullptr) device->restore_state(offset, value);
+}
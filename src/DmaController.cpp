@@ -0,0 +1,118 @@
+#include "../inc/DmaController.hpp"
+#include <cstring>
+#include <algorithm>
+
+
+DmaController::DmaController(Memory& memory, uint32_t cycles_per_word, Interrupt_line interrupt_line, Cycle_line cycle_line)
+  : memory(memory), cycles_per_word(cycles_per_word), interrupt_line(interrupt_line), cycle_line(cycle_line){}
+
+
+uint32_t DmaController::read(uint32_t /*core_id*/, uint32_t offset){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  if (offset == 0) return this->source;
+  if (offset == 4) return this->destination;
+  if (offset == 8) return this->length;
+  if (offset == 16) return this->status;
+  return 0;
+}
+
+void DmaController::write(uint32_t core_id, uint32_t offset, uint32_t value){
+  uint64_t cycles;
+  {
+    std::lock_guard<std::mutex> lock(this->register_mutex);
+
+    if (offset == 0) this->source = value;
+    else if (offset == 4) this->destination = value;
+    else if (offset == 8) this->length = value;
+    if (offset != 12) return;
+
+    this->status = this->transfer(value) ? 0 : 1;
+    cycles = ((uint64_t)this->length + 3) / 4 * this->cycles_per_word;
+  }
+
+  this->cycle_line(core_id, cycles);
+  this->interrupt_line(core_id, cause);
+}
+
+
+//Every page of both ranges is checked first, a failed transfer writes nothing
+bool DmaController::transfer(uint32_t mode){
+  if (mode != COPY && mode != FILL) return false;
+  if ((uint64_t)this->destination + this->length > ((uint64_t)1 << 32)) return false;
+  if (mode == COPY && (uint64_t)this->source + this->length > ((uint64_t)1 << 32)) return false;
+
+  try{
+    for (uint64_t done = 0; done < this->length; ){
+      uint32_t address = this->destination + done;
+      this->memory.write_span(address, nullptr, 0);
+      done += Memory::page_size - (address & (Memory::page_size - 1));
+    }
+    for (uint64_t done = 0; mode == COPY && done < this->length; ){
+      uint32_t address = this->source + done;
+      this->memory.read_span(address);
+      done += Memory::page_size - (address & (Memory::page_size - 1));
+    }
+  }
+  catch (const MemoryAccessViolation&){
+    return false;
+  }
+
+  if (mode == FILL){
+    uint8_t fill[Memory::page_size];
+    std::memset(fill, this->source & 0xFF, sizeof(fill));
+
+    for (uint32_t done = 0; done < this->length; ){
+      uint32_t address = this->destination + done;
+      uint32_t chunk = std::min(this->length - done, Memory::page_size - (address & (Memory::page_size - 1)));
+      this->memory.write_span(address, fill, chunk);
+      done += chunk;
+    }
+    return true;
+  }
+
+  //Chunks end at page boundaries of both ranges, a destination above an overlapping source copies backwards
+  bool backwards = this->destination > this->source && this->destination - this->source < this->length;
+  for (uint32_t done = 0; done < this->length; ){
+    uint32_t chunk;
+    if (!backwards){
+      uint32_t source = this->source + done, destination = this->destination + done;
+      chunk = std::min(this->length - done, std::min(Memory::page_size - (source & (Memory::page_size - 1)), Memory::page_size - (destination & (Memory::page_size - 1))));
+      this->copy_chunk(source, destination, chunk);
+    }
+    else{
+      uint32_t source_end = this->source + (this->length - done), destination_end = this->destination + (this->length - done);
+      chunk = std::min(this->length - done, std::min(((source_end - 1) & (Memory::page_size - 1)) + 1, ((destination_end - 1) & (Memory::page_size - 1)) + 1));
+      this->copy_chunk(source_end - chunk, destination_end - chunk, chunk);
+    }
+    done += chunk;
+  }
+
+  return true;
+}
+
+//Through a bounce buffer, source and destination may be the same page
+void DmaController::copy_chunk(uint32_t source, uint32_t destination, uint32_t bytes){
+  uint8_t data[Memory::page_size];
+  std::memcpy(data, this->memory.read_span(source), bytes);
+  this->memory.write_span(destination, data, bytes);
+}
+
+
+void DmaController::save_state(uint32_t base, Device_state& state){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  state.push_back({base, this->source});
+  state.push_back({base + 4, this->destination});
+  state.push_back({base + 8, this->length});
+  state.push_back({base + 16, this->status});
+}
+
+void DmaController::restore_state(uint32_t offset, uint32_t value){
+  std::lock_guard<std::mutex> lock(this->register_mutex);
+
+  if (offset == 0) this->source = value;
+  else if (offset == 4) this->destination = value;
+  else if (offset == 8) this->length = value;
+  else if (offset == 16) this->status = value;
+}
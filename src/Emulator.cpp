@@ -4,47 +4,46 @@
 std::ofstream Emulator::log_file("emulator.log");
 
 
-Emulator::Emulator(){
+Emulator::Emulator(Emulator_options options, Memory& memory, Bus& bus, uint32_t core_id): memory(memory), mmu(memory), bus(bus), core_id(core_id), options(options){
     //Load PC start address
     r[15] = this->start_address;
 
+    for(int op_code = 0; op_code < 256; op_code++) this->cycle_costs[op_code] = 1;
+    for(auto& cost : op_code_cycles) this->cycle_costs[cost.first] = cost.second;
+
     this->instruction_handlers = {
         {Instruction::INT, [&](unsigned char op_code) {
-            log_file << "INT " << std::hex << "0x" << (int)op_code << std::endl;
-
-            // push status; push pc; cause<=4; status<=status&(~0x1); pc<=handle;
+            if(this->options.trace_option) log_file << "INT " << std::hex << "0x" << (int)op_code << std::endl;
 
-            push(status);
-            push(r[15]);
-            cause = 4;
-            status = status &(~0x1); 
-            r[15] = handle;
+            trap(4);
 
         }},
         {Instruction::IRET, [&](unsigned char op_code) {
-            log_file << "IRET " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "IRET " << std::hex << "0x" << (int)op_code << std::endl;
 
             //pop pc; pop status;
 
             pop(r[15]);
             pop(status);
+            track_return();
 
         }},
         {Instruction::RET, [&](unsigned char op_code) {
-            log_file << "RET " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "RET " << std::hex << "0x" << (int)op_code << std::endl;
 
             //pop pc; 
 
             pop(r[15]);
+            track_return();
 
         }},
         {Instruction::CALL, [&](unsigned char op_code) {
-            log_file << "CALL " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "CALL " << std::hex << "0x" << (int)op_code << std::endl;
 
             //direct
             if(op_code == 0x20){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
@@ -52,13 +51,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -81,7 +80,7 @@ Emulator::Emulator(){
             //over memory
             else if(op_code == 0x21){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
@@ -89,13 +88,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -114,26 +113,27 @@ Emulator::Emulator(){
                 r[15] = read_memory_32(D);
             }
 
+            track_call(r[15]);
         }},
         {Instruction::JMP, [&](unsigned char op_code) {
-            log_file << "JMP " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "JMP " << std::hex << "0x" << (int)op_code << std::endl;
 
             if(op_code == 0x30){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 inc_pc(); 
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -152,20 +152,20 @@ Emulator::Emulator(){
             //memory
             else if(op_code == 0x38){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 inc_pc(); 
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -182,30 +182,30 @@ Emulator::Emulator(){
 
         }},
         {Instruction::BEQ, [&](unsigned char op_code) {
-            log_file << "BEQ " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "BEQ " << std::hex << "0x" << (int)op_code << std::endl;
 
 
             // direct
             if(op_code == 0x31){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -225,24 +225,24 @@ Emulator::Emulator(){
             //memory
             else if(op_code == 0x39){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -261,29 +261,29 @@ Emulator::Emulator(){
 
         }},
         {Instruction::BNE, [&](unsigned char op_code) {
-            log_file << "BNE " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "BNE " << std::hex << "0x" << (int)op_code << std::endl;
 
             // direct
             if(op_code == 0x32){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -303,24 +303,24 @@ Emulator::Emulator(){
             //memory
             else if(op_code == 0x3A){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -338,29 +338,29 @@ Emulator::Emulator(){
 
         }},
         {Instruction::BGT, [&](unsigned char op_code) {
-            log_file << "BGT " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "BGT " << std::hex << "0x" << (int)op_code << std::endl;
 
             // direct
             if(op_code == 0x33){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -380,24 +380,24 @@ Emulator::Emulator(){
             //memory
             else if(op_code == 0x3B){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -415,12 +415,12 @@ Emulator::Emulator(){
 
         }},
         {Instruction::PUSH, [&](unsigned char op_code) {
-            log_file << "PUSH " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "PUSH " << std::hex << "0x" << (int)op_code << std::endl;
 
             //1st byte
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             inc_pc();
@@ -432,12 +432,12 @@ Emulator::Emulator(){
 
         }},
         {Instruction::POP, [&](unsigned char op_code) {
-            log_file << "POP " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "POP " << std::hex << "0x" << (int)op_code << std::endl;
 
 
             //1st byte
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             inc_pc();
             inc_pc();
@@ -450,13 +450,13 @@ Emulator::Emulator(){
 
         }},
         {Instruction::XCHG, [&](unsigned char op_code) {
-            log_file << "XCHG " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "XCHG " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
 
@@ -469,14 +469,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::ADD, [&](unsigned char op_code) {
-            log_file << "ADD " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "ADD " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -485,14 +485,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::SUB, [&](unsigned char op_code) {
-            log_file << "SUB " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "SUB " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -500,14 +500,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::MUL, [&](unsigned char op_code) {
-            log_file << "MUL " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "MUL " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -515,14 +515,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::DIV, [&](unsigned char op_code) {
-            log_file << "DIV " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "DIV " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -530,11 +530,11 @@ Emulator::Emulator(){
 
         }},
         {Instruction::NOT, [&](unsigned char op_code) {
-            log_file << "NOT " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "NOT " << std::hex << "0x" << (int)op_code << std::endl;
             
             //2 BYTE instruction
             //GET A, B register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
@@ -543,14 +543,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::AND, [&](unsigned char op_code) {
-            log_file << "AND " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "AND " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -558,14 +558,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::OR, [&](unsigned char op_code) {
-            log_file << "OR " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "OR " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -573,14 +573,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::XOR, [&](unsigned char op_code) {
-            log_file << "XOR " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "XOR " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -588,14 +588,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::SHL, [&](unsigned char op_code) {
-            log_file << "SHL " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "SHL " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -603,14 +603,14 @@ Emulator::Emulator(){
 
         }},
         {Instruction::SHR, [&](unsigned char op_code) {
-            log_file << "SHR " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "SHR " << std::hex << "0x" << (int)op_code << std::endl;
 
             //GET A, B, C register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int& regB = r[byte & 0x0F];
             inc_pc();
-            byte= read_memory_byte(r[15]);
+            byte= fetch_byte(r[15]);
             int& regC = r[(byte & 0xF0) >> 4];
             inc_pc();
             
@@ -618,12 +618,12 @@ Emulator::Emulator(){
 
         }},
         {Instruction::LD, [&](unsigned char op_code) {
-            log_file << "LD " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "LD " << std::hex << "0x" << (int)op_code << std::endl;
 
             // direct
             if(op_code == 0x91){
                 //1st byte
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc(); 
@@ -632,13 +632,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -658,11 +658,11 @@ Emulator::Emulator(){
             else if(op_code == 0x92){
                 //1st byte
                 //GET A, B, C register references
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 int& regB = r[byte & 0x0F];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
@@ -670,13 +670,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -695,16 +695,16 @@ Emulator::Emulator(){
 
         }},
         {Instruction::ST, [&](unsigned char op_code) {
-            log_file << "ST " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "ST " << std::hex << "0x" << (int)op_code << std::endl;
 
             // direct
             if(op_code == 0x80){
                 //1st byte
                 //GET A, B, C register references
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
@@ -712,13 +712,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -739,10 +739,10 @@ Emulator::Emulator(){
             else if(op_code == 0x82){           //**MODIFIED**
                 //1st byte
                 //GET A, B, C register references
-                unsigned char byte= read_memory_byte(r[15]);
+                unsigned char byte= fetch_byte(r[15]);
                 int& regA = r[(byte & 0xF0) >> 4];
                 inc_pc();
-                byte= read_memory_byte(r[15]);
+                byte= fetch_byte(r[15]);
                 int& regC = r[(byte & 0xF0) >> 4];
                 inc_pc();
                 inc_pc();
@@ -750,13 +750,13 @@ Emulator::Emulator(){
 
                 //2nd byte
                 //literal pool below the instruction
-                unsigned char b1= read_memory_byte(r[15]);
+                unsigned char b1= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b2= read_memory_byte(r[15]);
+                unsigned char b2= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b3= read_memory_byte(r[15]);
+                unsigned char b3= fetch_byte(r[15]);
                 inc_pc();
-                unsigned char b4= read_memory_byte(r[15]);
+                unsigned char b4= fetch_byte(r[15]);
                 inc_pc();
                 //b1|b2|b3|b4
                 
@@ -776,11 +776,11 @@ Emulator::Emulator(){
 
         }},
         {Instruction::CSRRD, [&](unsigned char op_code) {
-            log_file << "CSRRD " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "CSRRD " << std::hex << "0x" << (int)op_code << std::endl;
 
             //2 BYTE instruction
             //GET A, B register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int& regA = r[(byte & 0xF0) >> 4];
             int b = (byte & 0x0F);
             inc_pc();
@@ -795,17 +795,25 @@ Emulator::Emulator(){
                 regA = handle;
             }else if(b == 2){   //cause
                 regA = cause;
+            }else if(b >= 3 && b <= 8){   //instret, cycle, time counters
+                regA = read_counter(b);
+            }else if(b == 9){   //page table base
+                regA = mmu.base();
+            }else if(b == 10){   //fault address
+                regA = fault_address;
+            }else if(b == 11){   //vector table base
+                regA = vector_base;
             }
 
 
 
         }},
         {Instruction::CSRWR, [&](unsigned char op_code) {
-            log_file << "CSRWR " << std::hex << "0x" << (int)op_code << std::endl;
+            if(this->options.trace_option) log_file << "CSRWR " << std::hex << "0x" << (int)op_code << std::endl;
 
             //2 BYTE instruction
             //GET A, B register references
-            unsigned char byte= read_memory_byte(r[15]);
+            unsigned char byte= fetch_byte(r[15]);
             int a = ((byte & 0xF0) >> 4);
             int& regB = r[(byte & 0x0F)];
             inc_pc();
@@ -818,104 +826,607 @@ Emulator::Emulator(){
                 handle = regB;
             }else if(a == 2){   //cause
                 cause = regB;
+            }else if(a == 9){   //page table base, flushes the tlb
+                mmu.set_base(regB);
+            }else if(a == 10){   //fault address
+                fault_address = regB;
+            }else if(a == 11){   //vector table base
+                vector_base = regB;
+            }else if(a == 12){   //host call
+                host_call(regB);
+            }
+
+        }},
+        {Instruction::CAS, [&](unsigned char op_code) {
+            if(this->options.trace_option) log_file << "CAS " << std::hex << "0x" << (int)op_code << std::endl;
+
+            //3 BYTE instruction
+            //GET A, B, C register references
+            unsigned char byte= fetch_byte(r[15]);
+            int& regA = r[(byte & 0xF0) >> 4];
+            int& regB = r[byte & 0x0F];
+            inc_pc();
+            byte= fetch_byte(r[15]);
+            int& regC = r[(byte & 0xF0) >> 4];
+            inc_pc();
+
+            //atomic: temp<=mem32[gpr[A]]; if(temp == gpr[B]) mem32[gpr[A]]<=gpr[C]; gpr[B]<=temp
+            //Device registers are not atomic memory, cas on them is a plain read and conditional write
+            uint32_t address = mmu.translate(regA, Mmu::READ);
+            if(mmu.translate(regA, Mmu::WRITE) != address || address >= Bus::mmio_base || (address & 3)){
+                uint32_t temp = read_memory_32(regA);
+                if(temp == (uint32_t)regB) write_memory_32(regA, regC);
+                regB = temp;
             }
+            else
+                regB = memory.compare_exchange_word(address, regB, regC);
+
+        }},
+        {Instruction::FENCE, [&](unsigned char op_code) {
+            if(this->options.trace_option) log_file << "FENCE " << std::hex << "0x" << (int)op_code << std::endl;
+
+            //Memory accesses before the fence are visible to all cores before any access after it
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        }},
+        {Instruction::TLBFLUSH, [&](unsigned char op_code) {
+            if(this->options.trace_option) log_file << "TLBFLUSH " << std::hex << "0x" << (int)op_code << std::endl;
+
+            //Translations of this core only, other cores flush themselves
+            mmu.flush();
+
+        }},
+        {Instruction::WAIT, [&](unsigned char op_code) {
+            if(this->options.trace_option) log_file << "WAIT " << std::hex << "0x" << (int)op_code << std::endl;
+
+            wait_for_interrupt();
 
         }}
 
     };
 
-    
+    //Dispatch by op code without hashing, halt and unknown op codes have no handler
+    for(int op_code = 0; op_code < 256; op_code++){
+        auto instruction = instruction_op_codes.find(op_code);
+        auto handler = instruction == instruction_op_codes.end() ? this->instruction_handlers.end() : this->instruction_handlers.find(instruction->second);
+        this->op_code_handlers[op_code] = handler == this->instruction_handlers.end() ? nullptr : &handler->second;
+
+        //Interrupts are checked where a basic block ends, where status may unmask them and after wait
+        Instruction type = instruction == instruction_op_codes.end() ? Instruction::NONE : instruction->second;
+        this->block_ends[op_code] = type == Instruction::INT || type == Instruction::IRET || type == Instruction::RET
+            || type == Instruction::CALL || type == Instruction::JMP || type == Instruction::BEQ || type == Instruction::BNE
+            || type == Instruction::BGT || type == Instruction::CSRWR || type == Instruction::WAIT;
+    }
 }
     
 
 Emulator::~Emulator(){
-  this->log_file.close();
-}
 
+}
 
-void Emulator::Emulate(std::ifstream& inputFile){
-    this->init_memory(inputFile);
 
-    this->execute();
+uint64_t Emulator::get_instruction_count() const{
+    return this->instruction_count;
+}
 
-    this->write_output(std::cout);
+bool Emulator::exited() const{
+    return this->exit_requested;
 }
 
+int Emulator::get_exit_status() const{
+    return this->exit_status;
+}
 
-void Emulator::init_memory(std::ifstream& inputFile){
-    std::string line;
-    std::string data;
-    uint32_t address = 0;
-
-    //FILL THE MEMORY MAP
-    while(getline(inputFile, line)) {
-        //empty line
-        if (line.empty() || line == "\n" || line.find_first_not_of(' ') == std::string::npos) {   
-            continue;
-        }
+const int* Emulator::get_registers() const{
+    return this->r;
+}
 
-        std::stringstream ss(line);
 
-        //Read address
-        ss>>data;
-        data.pop_back();
-        address = stoull("0x"+data, nullptr, 16);
+//Image pages come from a private copy-on-write view of the image host file, or are shared read-only
+//and copied by Memory. Snapshot state words restore the processor state.
+void Emulator::load(const Image& image){
+    this->image_view = image.private_view();
 
-        while(ss >> data){
-            try{
-                memory[address] = (unsigned char)stoi(data, nullptr, 16); 
-                // log_file<<std::hex<<(int)memory[address]<<" "<<address<<std::endl;
-            }
-            catch (const std::exception& e) {}
-            
-            address++;
-        }
+    if(this->image_view){
+        for(auto& page : image.page_offsets())
+            this->memory.map_page(page.first, this->image_view->writable_data() + page.second);
+    }
+    else{
+        for(auto& page : image.pages())
+            this->memory.share_page(page.first, page.second);
     }
 
+    uint64_t icount_low = 0, icount_high = 0, cycle_low = 0, cycle_high = 0;
+    uint64_t timer_low = (uint32_t)Timer::stopped, timer_high = (uint32_t)Timer::stopped;
+    uint32_t timer_config = 0;
+    for(auto& word : image.state()){
+        uint32_t key = word.first;
+        uint32_t value = word.second;
+
+        if(key < SNAPSHOT_R0 + 16) r[key - SNAPSHOT_R0] = value;
+        else if(key == SNAPSHOT_STATUS) status = value;
+        else if(key == SNAPSHOT_HANDLE) handle = value;
+        else if(key == SNAPSHOT_CAUSE) cause = value;
+        else if(key == SNAPSHOT_ICOUNT_LOW) icount_low = value;
+        else if(key == SNAPSHOT_ICOUNT_HIGH) icount_high = value;
+        else if(key == SNAPSHOT_CYCLE_LOW) cycle_low = value;
+        else if(key == SNAPSHOT_CYCLE_HIGH) cycle_high = value;
+        else if(key == SNAPSHOT_PTBR) this->mmu.set_base(value);
+        else if(key == SNAPSHOT_FAULT_ADDRESS) this->fault_address = value;
+        else if(key == SNAPSHOT_VECTOR_BASE) this->vector_base = value;
+        else if(key == SNAPSHOT_TIMER_CONFIG) timer_config = value;
+        else if(key == SNAPSHOT_TIMER_DEADLINE_LOW) timer_low = value;
+        else if(key == SNAPSHOT_TIMER_DEADLINE_HIGH) timer_high = value;
+        else if(key >= Bus::mmio_base) this->bus.restore_state(key, value);
+    }
+    this->instruction_count = (icount_high << 32) | icount_low;
+    this->cycle_count = (cycle_high << 32) | cycle_low;
+    if(this->timer && !image.state().empty()) this->timer->restore(timer_config, (timer_high << 32) | timer_low);
 
     //ALLOCATE MEMORY MAPPED REGISTERS from address 0xFFFFFF00 of size 256 bytes
-    for(int address = 0xFFFFFF00; address<0xFFFFFF00 + 256; address++)
-        memory[address] = 0;  //o initialized
+    uint32_t mmio_page = Bus::mmio_base / Memory::page_size;
+    if(!this->options.protect_option){
+        this->memory.protect(mmio_page, Memory::PAGE_ALL);
+        return;
+    }
 
+    //Protected memory: stack pages below the registers, read/write only.
+    //Image pages keep all permissions, images do not say which of their pages hold code
+    for(uint32_t page_number = mmio_page - this->options.stack_pages; page_number <= mmio_page; page_number++)
+        if(this->memory.find_page(page_number) == nullptr)
+            this->memory.protect(page_number, Memory::PAGE_READ | Memory::PAGE_WRITE);
 }
 
 
-void Emulator::execute(){
-    while(true){
-        unsigned char op_code = read_memory_byte(r[15]);
-        inc_pc();
+static std::map<uint8_t, std::string> op_code_names(){
+    std::map<uint8_t, std::string> names;
+    for(auto& op_code : instruction_op_codes) names[op_code.first] = Instruction_name.at(op_code.second);
+    return names;
+}
+
+
+void Emulator::run(){
+    if(!this->options.record_file_name.empty())
+        this->journal.reset(new Journal(this->options.record_file_name, Journal::Mode::RECORD));
+    else if(!this->options.replay_file_name.empty())
+        this->journal.reset(new Journal(this->options.replay_file_name, Journal::Mode::REPLAY));
+
+    this->start_time = std::chrono::steady_clock::now();
+    if(this->journal && this->journal->mode() == Journal::Mode::REPLAY) this->check_interval = 1;
+    this->interrupt_countdown = this->check_interval;
 
+    if(!this->options.profile_prefix.empty()){
+        this->profiler.reset(new Profiler(this->options.profile_prefix, r[15]));
+        if(!this->options.map_file_name.empty()) this->profiler->load_symbols(this->options.map_file_name);
+    }
+    if(!this->options.sample_prefix.empty()){
+        this->sampler.reset(new Sampler(this->options.sample_prefix, this->options.sample_interval, r[15], this->interrupts.word(), InterruptController::attention));
+        if(!this->options.map_file_name.empty()) this->sampler->load_symbols(this->options.map_file_name);
+    }
+#ifdef INSTRUCTION_MIX
+    this->instruction_mix.reset(new InstructionMix(op_code_names()));
+#endif
+
+    //Stopped cores no longer wake waiting ones, failed ones included
+    try { this->execute(); }
+    catch(...){
+        if(this->smp) this->smp->stop(this->core_id);
+        throw;
+    }
+    if(this->smp) this->smp->stop(this->core_id);
+    if(this->terminal) this->terminal->flush();
 
-        if(instruction_op_codes.at(op_code) == Instruction::HALT) break;
+    this->finish_journal();
 
-        std::cout<<std::hex<<(int)op_code<<std::endl;
+    if(this->profiler) this->profiler->write(op_code_names());
+    if(this->sampler){
+        this->sampler->stop();
+        this->sampler->write();
+    }
+#ifdef INSTRUCTION_MIX
+    this->instruction_mix->write(this->options.core_count > 1 ? this->options.mix_prefix + ".core" + std::to_string(this->core_id) : this->options.mix_prefix);
+#endif
+}
 
-        if(this->instruction_handlers.find(instruction_op_codes.at(op_code)) != this->instruction_handlers.end())
-            this->instruction_handlers.at(instruction_op_codes.at(op_code))(op_code);
-        else 
-            throw UnrecognizedOperactionCode(op_code);
+
+//Whole machine state into a paged image: processor state words and all present memory pages
+void Emulator::save_snapshot(){
+    if(this->terminal) this->terminal->flush();       //output so far belongs before the snapshot
+
+    std::vector<std::pair<uint32_t, uint32_t>> state;
+    for(int i = 0; i < 16; i++) state.push_back({SNAPSHOT_R0 + i, (uint32_t)r[i]});
+    state.push_back({SNAPSHOT_STATUS, (uint32_t)status});
+    state.push_back({SNAPSHOT_HANDLE, (uint32_t)handle});
+    state.push_back({SNAPSHOT_CAUSE, (uint32_t)cause});
+    state.push_back({SNAPSHOT_ICOUNT_LOW, (uint32_t)this->instruction_count});
+    state.push_back({SNAPSHOT_ICOUNT_HIGH, (uint32_t)(this->instruction_count >> 32)});
+    state.push_back({SNAPSHOT_CYCLE_LOW, (uint32_t)this->cycle_count});
+    state.push_back({SNAPSHOT_CYCLE_HIGH, (uint32_t)(this->cycle_count >> 32)});
+    state.push_back({SNAPSHOT_PTBR, this->mmu.base()});
+    state.push_back({SNAPSHOT_FAULT_ADDRESS, this->fault_address});
+    state.push_back({SNAPSHOT_VECTOR_BASE, this->vector_base});
+    if(this->timer){
+        uint64_t deadline = this->timer->next_deadline();
+        state.push_back({SNAPSHOT_TIMER_CONFIG, this->timer->config()});
+        state.push_back({SNAPSHOT_TIMER_DEADLINE_LOW, (uint32_t)deadline});
+        state.push_back({SNAPSHOT_TIMER_DEADLINE_HIGH, (uint32_t)(deadline >> 32)});
+    }
+    this->bus.save_state(state);
+
+    std::map<uint32_t, std::vector<uint8_t>> pages;
+    for(uint32_t page_number : this->memory.page_numbers()){
+        const uint8_t* page = this->memory.find_page(page_number);
+        pages[page_number].assign(page, page + Memory::page_size);
+    }
+
+    OutputWriter output_file(this->options.snapshot_file_name);
+    output_file.write_paged_image(pages, state);
+    output_file.close();
+
+    this->snapshot_taken = true;
+    this->log_file << "Snapshot saved at instruction " << std::dec << this->instruction_count << std::endl;
+}
+
+
+void Emulator::execute(){
+    while(true){
+        if(this->options.snapshot_option && !this->snapshot_taken
+            && (this->options.snapshot_at_pc ? (uint32_t)r[15] == this->options.snapshot_pc : this->instruction_count == this->options.snapshot_icount))
+            this->save_snapshot();
+
+        //Faulting instructions restart, handlers change registers other than pc and sp only after their accesses.
+        //They retire only when they complete, so a restart is not counted in instret and cycle twice
+        int instruction_pc = r[15];
+        int instruction_sp = r[14];
+        uint64_t retired_count = this->instruction_count;
+        uint64_t retired_cycles = this->cycle_count;
+        unsigned char op_code = 0;
+
+        try{
+            op_code = fetch_byte(r[15]);
+            if(this->profiler) this->profiler->instruction(r[15], op_code);
+            inc_pc();
+            this->instruction_count++;
+            this->cycle_count += this->cycle_costs[op_code];
+#ifdef INSTRUCTION_MIX
+            this->instruction_mix->record(op_code);
+#endif
+
+
+            std::function<void(unsigned char op_code)>* handler = this->op_code_handlers[op_code];
+            if(handler != nullptr)
+                (*handler)(op_code);
+            else if(instruction_op_codes.count(op_code) && instruction_op_codes.at(op_code) == Instruction::HALT)
+                break;
+            else 
+                throw UnrecognizedOperactionCode(op_code);
+        }
+        catch(const MemoryAccessViolation& violation){
+            r[15] = instruction_pc;
+            r[14] = instruction_sp;
+            if(this->profiler && this->instruction_count != retired_count) this->profiler->retract(instruction_pc, op_code);
+            this->instruction_count = retired_count;
+            this->cycle_count = retired_cycles;
+            this->fault_address = violation.address;
+            this->trap(6);          //a fault while entering the handler leaves execute
+        }
+        catch(const PageFault& page_fault){
+            r[15] = instruction_pc;
+            r[14] = instruction_sp;
+            if(this->profiler && this->instruction_count != retired_count) this->profiler->retract(instruction_pc, op_code);
+            this->instruction_count = retired_count;
+            this->cycle_count = retired_cycles;
+            this->fault_address = page_fault.address;
+            this->trap(7);
+        }
 
         
-        this->log_file<<Instruction_name.at(instruction_op_codes.at(op_code))<<" "<<std::hex<<(int)op_code<<"  ";
-        this->log_file<<"handle: "<<handle<<"   cause:"<<cause<<"   status: "<<status<<std::endl;
-        write_output(this->log_file);
-        this->log_file<<std::endl;
-        this->log_file<<std::endl;
-        this->log_file<<std::endl;
-
-        this->interrupt_check();
+        if(this->options.trace_option){
+            this->log_file<<Instruction_name.at(instruction_op_codes.at(op_code))<<" "<<std::hex<<(int)op_code<<"  ";
+            this->log_file<<"handle: "<<handle<<"   cause:"<<cause<<"   status: "<<status<<std::endl;
+            write_output(this->log_file);
+            this->log_file<<std::endl;
+            this->log_file<<std::endl;
+            this->log_file<<std::endl;
+        }
+
+        if(this->block_ends[op_code] || --this->interrupt_countdown == 0){
+            if(this->exit_requested) break;
+            this->interrupt_countdown = this->check_interval;
+            this->interrupt_check();
+        }
         // break;     //remove this
     }
 }
 
 
+//Interrupts are taken between instructions, at basic block ends and every interrupt_interval instructions.
+//On replay they come only from the journal, before the same instruction as in the recorded run
 void Emulator::interrupt_check(){
+    if(this->timer && this->timer->expired(this->cycle_count) && this->timer->tick(this->cycle_count))
+        this->interrupts.raise(Timer::cause);
+    if(this->terminal) this->terminal->poll(this->cycle_count);
+
+    if(this->journal && this->journal->mode() == Journal::Mode::REPLAY){
+        if(this->interrupts.take_attention() && this->sampler) this->sampler->sample(r[15]);
+
+        const Journal_entry* entry = this->journal->peek();
+        while(entry != nullptr && entry->event == Journal_event::INTERRUPT && entry->instruction_count == this->instruction_count){
+            this->trap(this->journal->next().value);
+            status = status | 0x4;
+            entry = this->journal->peek();
+        }
+        return;
+    }
+
+    if(!this->interrupts.any()) return;
+
+    //Sampling rides on the pending word so the loop checks nothing else
+    if(this->interrupts.take_attention() && this->sampler) this->sampler->sample(r[15]);
+
+    int interrupt_cause = this->interrupts.take(status);
+    if(interrupt_cause < 0) return;
+
+    if(this->journal) this->journal->record({Journal_event::INTERRUPT, this->instruction_count, 0, (uint32_t)interrupt_cause});
+
+    this->trap(interrupt_cause);
+    status = status | 0x4;          //no nesting, iret restores status
+}
 
+
+//wait: the core parks until an interrupt is pending, masked or not. With the timer running nothing in
+//virtual time happens before its deadline, so the cycle count jumps there. Otherwise the host thread
+//sleeps until another core or the sampler raises something. Devices finish their work before the store that
+//starts it returns, so once every other core has stopped or parked the same way nothing can end the wait.
+//How far the cycle count jumped depends on what was pending, so it is an input to the journal, on replay
+//the jump comes from there
+void Emulator::wait_for_interrupt(){
+    uint64_t skipped = 0;
+    bool parked = false;
+
+    if(!this->journal || this->journal->mode() != Journal::Mode::REPLAY){
+        while(!this->interrupts.any()){
+            uint64_t now = this->cycle_count + skipped;
+            uint64_t deadline = this->timer ? this->timer->next_deadline() : Timer::stopped;
+            if(deadline == Timer::stopped){
+                if(!parked && this->smp) this->smp->park(this->core_id);
+                parked = true;
+
+                //Another core may have armed the timer or raised an IPI before it stopped
+                if((!this->smp || !this->smp->any_awake()) && !this->interrupts.any()
+                    && (!this->timer || this->timer->next_deadline() == Timer::stopped))
+                    throw WaitDeadlockError(this->core_id, r[15]);
+
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+
+            if(now < deadline) skipped += deadline - now;
+            if(this->timer->tick(this->cycle_count + skipped)) this->interrupts.raise(Timer::cause);
+        }
+        if(parked && this->smp) this->smp->unpark(this->core_id);
+    }
+
+    //A jump is at most one timer period, it fits the journal value
+    this->cycle_count += this->input(JOURNAL_WAIT, (uint32_t)skipped);
+}
+
+
+//Host calls (HostCall.hpp). Guest buffers are checked page by page before any host I/O, so a faulting
+//call restarts without side effects. Results and read data are inputs to the journal, on replay they come
+//from there and only writes to stdout and stderr reach the host
+void Emulator::host_call(uint32_t call){
+    bool replay = this->journal && this->journal->mode() == Journal::Mode::REPLAY;
+    int handle = r[1];
+    uint32_t buffer = r[2], size = r[3];
+    int result = -1;
+
+    if(call == HostCall::OPEN){
+        std::string path;
+        for(uint32_t address = r[1]; path.size() < Memory::page_size; address++){
+            char c = read_memory_byte(address);
+            if(c == 0) break;
+            path += c;
+        }
+        if(!replay) result = this->host.open(path, r[2]);
+    }
+    else if(call == HostCall::CLOSE){
+        if(!replay) result = this->host.close(handle);
+    }
+    else if(call == HostCall::READ){
+        check_guest_buffer(buffer, size, Mmu::WRITE);
+
+        uint8_t data[Memory::page_size];
+        result = 0;
+        for(uint32_t done = 0; done < size; ){
+            uint32_t address = buffer + done;
+            uint32_t chunk = std::min(size - done, Memory::page_size - (address & (Memory::page_size - 1)));
+
+            int count = replay ? 0 : this->host.read(handle, data, chunk);
+            count = this->input(JOURNAL_HOST_CALL, count);
+            if(count < 0){
+                result = -1;
+                break;
+            }
+            //Read bytes packed into words, the last word only holds the bytes that were read
+            for(int i = 0; this->journal && i < count; i += 4){
+                int bytes = std::min(4, count - i);
+                uint32_t word = 0;
+                for(int j = 0; j < bytes; j++) word |= (uint32_t)data[i + j] << (j * 8);
+                word = this->input(JOURNAL_HOST_CALL, word);
+                for(int j = 0; j < bytes; j++) data[i + j] = word >> (j * 8);
+            }
+
+            if(count > 0) this->memory.write_span(mmu.translate(address, Mmu::WRITE), data, count);
+            result += count;
+            done += count;
+            if((uint32_t)count < chunk) break;
+        }
+        r[1] = result;
+        return;
+    }
+    else if(call == HostCall::WRITE){
+        check_guest_buffer(buffer, size, Mmu::READ);
+        if(this->terminal && (handle == 1 || handle == 2)) this->terminal->flush();      //keep the order of guest output
+
+        result = 0;
+        for(uint32_t done = 0; done < size && (!replay || handle == 1 || handle == 2); ){
+            uint32_t address = buffer + done;
+            uint32_t chunk = std::min(size - done, Memory::page_size - (address & (Memory::page_size - 1)));
+
+            int count = this->host.write(handle, this->memory.read_span(mmu.translate(address, Mmu::READ)), chunk);
+            if(count < 0){
+                result = -1;
+                break;
+            }
+            result += count;
+            done += count;
+        }
+    }
+    else if(call == HostCall::TIME){
+        r[1] = read_counter(7);
+        r[2] = read_counter(8);
+        return;
+    }
+    else if(call == HostCall::EXIT){
+        this->exit_requested = true;
+        this->exit_status = r[1];
+        this->host.flush();
+        return;
+    }
+    else{
+        r[1] = -1;
+        return;
+    }
+
+    r[1] = this->input(JOURNAL_HOST_CALL, result);
+}
+
+void Emulator::check_guest_buffer(uint32_t address, uint32_t size, Mmu::Access access){
+    for(uint32_t done = 0; done < size; ){
+        uint32_t physical = mmu.translate(address + done, access);
+        if(access == Mmu::READ) this->memory.read_span(physical);
+        else this->memory.write_span(physical, nullptr, 0);
+
+        done += Memory::page_size - ((address + done) & (Memory::page_size - 1));
+    }
+}
+
+
+//Vectored mode (ivt csr set): the handler is the word for the cause in the vector table, a zero word
+//falls back to handle. The table is read through the mmu like any guest data
+void Emulator::trap(int trap_cause){
+    // push status; push pc; cause<=trap_cause; status<=status&(~0x1); pc<=handle | mem32[ivt+cause*4];
+
+    push(status);
+    push(r[15]);
+    cause = trap_cause;
+    status = status &(~0x1); 
+
+    uint32_t target = handle;
+    if(vector_base != 0){
+        uint32_t vector = read_memory_32(vector_base + trap_cause * 4);
+        if(vector != 0) target = vector;
+    }
+    r[15] = target;
+
+    track_call(target);
+}
+
+
+//Call, trap and return events for the profilers, off the dispatch loop
+void Emulator::track_call(uint32_t target){
+    if(this->profiler) this->profiler->call(target);
+    if(this->sampler) this->sampler->call(target);
+}
+
+void Emulator::track_return(){
+    if(this->profiler) this->profiler->ret();
+    if(this->sampler) this->sampler->ret();
+}
+
+
+//Devices and other cores raise interrupts here, ignored on replay where the journal decides
+void Emulator::request_interrupt(int interrupt_cause){
+    this->interrupts.raise(interrupt_cause);
+}
+
+void Emulator::charge_cycles(uint64_t cycles){
+    this->cycle_count += cycles;
+}
+
+void Emulator::attach_timer(Timer* timer){
+    this->timer = timer;
+}
+
+void Emulator::attach_terminal(Terminal* terminal){
+    this->terminal = terminal;
+}
+
+void Emulator::attach_smp(SmpController* smp){
+    this->smp = smp;
+}
+
+
+//Every value that does not follow from the memory image passes through here
+//Counters count the reading instruction. Reading the low word latches the high word so a
+//low, high read pair is consistent. Time is host microseconds since the run started, an input
+//to the guest, so it goes through the journal
+uint32_t Emulator::read_counter(int csr){
+    uint64_t value = 0;
+    int counter = (csr - 3) / 2;
+    bool high = (csr - 3) % 2;
+
+    if(high) return this->counter_high[counter];
+
+    if(counter == 0) value = this->instruction_count;
+    else if(counter == 1) value = this->cycle_count;
+    else{
+        uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start_time).count();
+        value = this->input(JOURNAL_TIMER, (uint32_t)now);
+        value |= (uint64_t)this->input(JOURNAL_TIMER, (uint32_t)(now >> 32)) << 32;
+    }
+
+    this->counter_high[counter] = value >> 32;
+    return (uint32_t)value;
+}
+
+
+uint32_t Emulator::input(Journal_source source, uint32_t live_value){
+    if(!this->journal) return live_value;
+
+    if(this->journal->mode() == Journal::Mode::RECORD){
+        this->journal->record({Journal_event::INPUT, this->instruction_count, source, live_value});
+        return live_value;
+    }
+
+    Journal_entry entry = this->journal->next();
+    if(entry.event != Journal_event::INPUT || entry.source != source || entry.instruction_count != this->instruction_count)
+        throw ReplayDivergenceError("unexpected input at instruction " + std::to_string(this->instruction_count));
+
+    return entry.value;
+}
+
+
+//Recorded runs end with the halt position, replayed runs must end at the same one
+void Emulator::finish_journal(){
+    if(!this->journal) return;
+
+    if(this->journal->mode() == Journal::Mode::RECORD)
+        this->journal->record({Journal_event::HALT, this->instruction_count, 0, (uint32_t)r[15]});
+    else{
+        Journal_entry entry = this->journal->next();
+        if(entry.event != Journal_event::HALT || entry.instruction_count != this->instruction_count || entry.value != (uint32_t)r[15])
+            throw ReplayDivergenceError("halted at instruction " + std::to_string(this->instruction_count));
+    }
+
+    this->journal->close();
 }
 
 void Emulator::write_output(std::ostream& os){
     os << "------------------------------------------------\n";
-    os << "Emulated processor executed halt instruction    \n";
+    if(this->exit_requested) os << "Emulated program exited with status " << std::dec << this->exit_status << "\n";
+    else os << "Emulated processor executed halt instruction    \n";
     os << "Emulated processor state: \n";
     for (int i = 0; i < 16; i++) {
         if(i % 4 == 0) os<<std::endl;
@@ -931,68 +1442,62 @@ void Emulator::inc_pc() {
     r[15]++;
 }
 
-unsigned char Emulator::read_memory_byte(int address) {
-
-    // if (memory.find(address) == memory.end()){
-    //     std::cout<<"Can not read from address: "<<std::hex<<address<<std::endl;
-    //     throw MemoryReadViolation(address);
-    // }
+//Guest addresses are virtual, the mmu translates them before memory and devices see them.
+//Page permissions are checked by Memory, violations and page faults become guest faults in execute
+unsigned char Emulator::fetch_byte(int address) {
+    return memory.fetch_byte(mmu.translate(address, Mmu::EXECUTE));
+}
 
-    return memory[address];
+unsigned char Emulator::read_memory_byte(int address) {
+    return memory.read_byte(mmu.translate(address, Mmu::READ));
 }
 
 
 uint32_t Emulator::read_memory_32(int address) {
-
-    // unsigned char b1= read_memory_byte(r[15]);
-    // inc_pc();
-    // unsigned char b2= read_memory_byte(r[15]);
-    // inc_pc();
-    // unsigned char b3= read_memory_byte(r[15]);
-    // inc_pc();
-    // unsigned char b4= read_memory_byte(r[15]);
-    // inc_pc();
-    // //b1|b2|b3|b4
+    //Words crossing a page may cross frames
+    if((address & (Memory::page_size - 1)) > Memory::page_size - 4)
+        return ((uint32_t)read_memory_byte(address) << 24) | ((uint32_t)read_memory_byte(address + 1) << 16)
+            | ((uint32_t)read_memory_byte(address + 2) << 8) | read_memory_byte(address + 3);
+
+    uint32_t physical = mmu.translate(address, Mmu::READ);
+
+    //Device registers
+    if(physical >= Bus::mmio_base){
+        uint32_t offset;
+        Device* device = this->bus.find(physical, offset);
+        if(device != nullptr) return device->read(this->core_id, offset);
+    }
 
     //***MODIFIED***
-    unsigned char b1= read_memory_byte(address);
-    unsigned char b2= read_memory_byte(address+1);
-    unsigned char b3= read_memory_byte(address+2);
-    unsigned char b4= read_memory_byte(address+3);
-
-    uint32_t D = 0;
-    D |= static_cast<uint32_t>(b1) << 24;  
-    D |= static_cast<uint32_t>(b2) << 16;  
-    D |= static_cast<uint32_t>(b3) << 8;  
-    D |= static_cast<uint32_t>(b4); 
-
-    return D;
+    return memory.read_word(physical);
 }
 
 
 
 void Emulator::write_memory_byte(int address, unsigned char value) {
-    // if (memory.find(address) == memory.end()){
-    //     std::cout<<"Can not write to address: "<<std::hex<<address<<std::endl;
-    //     throw MemoryReadViolation(address);
-    // } 
-    
-
-    memory[address] = value;
+    memory.write_byte(mmu.translate(address, Mmu::WRITE), value);
 }
 
 void Emulator::write_memory_32(int address, uint32_t value){
-    // write_memory_byte(address, (value & 0xFF000000) >> 24);
-    // write_memory_byte(address, (value & 0x00FF0000) >> 16);
-    // write_memory_byte(address, (value & 0x0000FF00) >> 8);
-    // write_memory_byte(address, value &  0x000000FF);
+    if((address & (Memory::page_size - 1)) > Memory::page_size - 4){
+        write_memory_byte(address, value >> 24);
+        write_memory_byte(address + 1, value >> 16);
+        write_memory_byte(address + 2, value >> 8);
+        write_memory_byte(address + 3, value);
+        return;
+    }
 
-    //***MODIFIED***
-     write_memory_byte(address, (value & 0xFF000000) >> 24);
-    write_memory_byte(address+1, (value & 0x00FF0000) >> 16);
-    write_memory_byte(address+2, (value & 0x0000FF00) >> 8);
-    write_memory_byte(address+3, value &  0x000000FF);
+    uint32_t physical = mmu.translate(address, Mmu::WRITE);
 
+    //Device registers
+    if(physical >= Bus::mmio_base){
+        uint32_t offset;
+        Device* device = this->bus.find(physical, offset);
+        if(device != nullptr) return device->write(this->core_id, offset, value);
+    }
+
+    //***MODIFIED***
+    memory.write_word(physical, value);
 }
 
 
@@ -1006,26 +1511,369 @@ void Emulator::pop(int& val) {
 }
 
 
+//Fleet job from the manifest
+struct Fleet_job{
+    std::string name;
+    std::string image_file_name;
+    std::string replay_file_name;
+};
+
+
+//Runs many independent single core jobs on a work-stealing pool. Manifest lines:
+//  job_name image_file [--replay=journal]
+//Empty lines and lines starting with # are skipped. Every image is parsed once and its pages are shared by all jobs
+//using it. One summary line per job, in manifest order.
+static void run_fleet(const Emulator_options& options){
+    std::ifstream manifest_file(options.fleet_file_name);
+    if (!manifest_file.is_open())
+        throw FileNameError(options.fleet_file_name);
+
+    std::regex replay_regex(R"(^--replay=(.+)$)");
+    std::smatch match;
+    std::vector<Fleet_job> jobs;
+    std::map<std::string, std::unique_ptr<Image>> images;
+    std::map<std::string, std::string> image_errors;
+    std::string line;
+
+    while (getline(manifest_file, line)){
+        std::stringstream ss(line);
+        Fleet_job job;
+        if (!(ss >> job.name) || job.name[0] == '#') continue;
+        if (!(ss >> job.image_file_name)) throw InvalidFleetManifest(options.fleet_file_name, line);
+
+        std::string token;
+        while (ss >> token){
+            if (!regex_search(token, match, replay_regex)) throw InvalidFleetManifest(options.fleet_file_name, line);
+            job.replay_file_name = match[1];
+        }
+
+        //Unreadable images fail their jobs, not the fleet
+        if (images.find(job.image_file_name) == images.end()){
+            try { images[job.image_file_name].reset(new Image(job.image_file_name)); }
+            catch(const std::exception& e) { image_errors[job.image_file_name] = e.what(); }
+        }
+        jobs.push_back(job);
+    }
+
+    std::vector<std::string> results(jobs.size());
+    ThreadPool thread_pool(options.thread_count);
+
+    for (size_t i = 0; i < jobs.size(); i++)
+        thread_pool.submit([&options, &jobs, &images, &image_errors, &results, i](){
+            Emulator_options job_options = options;
+            job_options.replay_file_name = jobs[i].replay_file_name;
+            job_options.mix_prefix = options.mix_prefix + "." + jobs[i].name;
+
+            Memory memory(job_options.protect_option);
+            Bus bus;
+            Timer timer;
+            Emulator emulator(job_options, memory, bus);
+            bus.attach(Timer::base, Timer::size, &timer);
+            emulator.attach_timer(&timer);
+            DmaController dma_controller(memory, job_options.dma_cycles_per_word, [&emulator](uint32_t, int interrupt_cause){
+                emulator.request_interrupt(interrupt_cause);
+            }, [&emulator](uint32_t, uint64_t cycles){
+                emulator.charge_cycles(cycles);
+            });
+            bus.attach(DmaController::base, DmaController::size, &dma_controller);
+            std::stringstream result;
+            result << std::left << std::setw(25) << jobs[i].name;
+
+            try{
+                const std::unique_ptr<Image>& image = images.at(jobs[i].image_file_name);
+                if (!image) throw std::runtime_error(image_errors.at(jobs[i].image_file_name));
+
+                emulator.load(*image);
+                emulator.run();
+
+                result << std::setw(10) << (emulator.exited() ? "exit " + std::to_string(emulator.get_exit_status()) : "halted") << std::setw(15) << std::dec << emulator.get_instruction_count();
+                for (int j = 0; j < 16; j++)
+                    result << "0x" << std::right << std::setfill('0') << std::setw(8) << std::hex << emulator.get_registers()[j] << std::setfill(' ') << " ";
+            }
+            catch(const std::exception& e){
+                result << std::setw(10) << "error" << e.what();
+            }
+
+            results[i] = result.str();
+        });
+
+    thread_pool.wait();
+
+    std::ofstream summary_file(options.summary_file_name);
+    if (!summary_file.is_open())
+        throw FileNameError(options.summary_file_name);
+
+    summary_file << std::left << std::setw(25) << "Job" << std::setw(10) << "Status" << std::setw(15) << "Instructions" << "r0 - r15\n";
+    for (const std::string& result : results)
+        summary_file << result << "\n";
+
+    std::cout << "Fleet finished: " << std::dec << jobs.size() << " jobs, summary in " << options.summary_file_name << "\n";
+}
+
+
 int main(int argc, char* argv[]) {
   try {
-   
-    if (argc < 2)
+
+    Emulator_options options;
+    std::regex snapshot_at_regex(R"(^--snapshot-at=(pc|icount):(\d+|0x[0-9a-fA-F]+)$)");
+    std::regex snapshot_regex(R"(^--snapshot=(.+)$)");
+    std::regex restore_regex(R"(^--restore=(.+)$)");
+    std::regex record_regex(R"(^--record=(.+)$)");
+    std::regex replay_regex(R"(^--replay=(.+)$)");
+    std::regex cores_regex(R"(^--cores=(\d+)$)");
+    std::regex fleet_regex(R"(^--fleet=(.+)$)");
+    std::regex summary_regex(R"(^--summary=(.+)$)");
+    std::regex threads_regex(R"(^--threads=(\d+)$)");
+    std::regex profile_regex(R"(^--profile=(.+)$)");
+    std::regex sample_regex(R"(^--sample=(.+)$)");
+    std::regex sample_interval_regex(R"(^--sample-interval=(\d+)$)");
+    std::regex map_regex(R"(^--map=(.+)$)");
+    std::regex stack_pages_regex(R"(^--stack-pages=(\d+)$)");
+    std::regex disk_regex(R"(^--disk=(.+)$)");
+    std::regex dma_cost_regex(R"(^--dma-cost=(\d+)$)");
+#ifdef INSTRUCTION_MIX
+    std::regex mix_regex(R"(^--mix=(.+)$)");
+#endif
+    std::smatch match;
+    std::string input_file_name;
+
+    for(int i = 1; i < argc; i++){
+      std::string token = argv[i];
+
+      //--snapshot-at=pc:address | --snapshot-at=icount:count
+      if (regex_search(token, match, snapshot_at_regex)) {
+        options.snapshot_option = true;
+        options.snapshot_at_pc = match[1] == "pc";
+        if (options.snapshot_at_pc) options.snapshot_pc = stoul(match[2], nullptr, 0);
+        else options.snapshot_icount = stoull(match[2], nullptr, 0);
+        continue;
+      }
+
+      //--snapshot=file
+      if (regex_search(token, match, snapshot_regex)) {
+        options.snapshot_file_name = match[1];
+        continue;
+      }
+
+      //--restore=file
+      if (regex_search(token, match, restore_regex)) {
+        options.restore_file_name = match[1];
+        continue;
+      }
+
+      //--record=journal
+      if (regex_search(token, match, record_regex)) {
+        options.record_file_name = match[1];
+        continue;
+      }
+
+      //--replay=journal
+      if (regex_search(token, match, replay_regex)) {
+        options.replay_file_name = match[1];
+        continue;
+      }
+
+      //--cores=N
+      if (regex_search(token, match, cores_regex)) {
+        options.core_count = stoul(match[1]);
+        if (options.core_count == 0) throw InvalidEmulatorCmdArgs();
+        continue;
+      }
+
+      //--fleet=manifest
+      if (regex_search(token, match, fleet_regex)) {
+        options.fleet_file_name = match[1];
+        continue;
+      }
+
+      //--summary=file
+      if (regex_search(token, match, summary_regex)) {
+        options.summary_file_name = match[1];
+        continue;
+      }
+
+      //--threads=N
+      if (regex_search(token, match, threads_regex)) {
+        options.thread_count = stoul(match[1]);
+        continue;
+      }
+
+      //--profile=prefix
+      if (regex_search(token, match, profile_regex)) {
+        options.profile_prefix = match[1];
+        continue;
+      }
+
+      //--sample=prefix
+      if (regex_search(token, match, sample_regex)) {
+        options.sample_prefix = match[1];
+        continue;
+      }
+
+      //--sample-interval=usec
+      if (regex_search(token, match, sample_interval_regex)) {
+        options.sample_interval = std::stoul(match[1]);
+        if (options.sample_interval == 0) throw InvalidEmulatorCmdArgs();
+        continue;
+      }
+
+      //--map=file
+      if (regex_search(token, match, map_regex)) {
+        options.map_file_name = match[1];
+        continue;
+      }
+
+#ifdef INSTRUCTION_MIX
+      //--mix=prefix
+      if (regex_search(token, match, mix_regex)) {
+        options.mix_prefix = match[1];
+        continue;
+      }
+#endif
+
+      //--stack-pages=N
+      if (regex_search(token, match, stack_pages_regex)) {
+        options.stack_pages = std::stoul(match[1]);
+        if (options.stack_pages >= Bus::mmio_base / Memory::page_size) throw InvalidEmulatorCmdArgs();
+        continue;
+      }
+
+      //--protect
+      if (token == "--protect") {
+        options.protect_option = true;
+        continue;
+      }
+
+      //--disk=file
+      if (regex_search(token, match, disk_regex)) {
+        options.disk_file_name = match[1];
+        continue;
+      }
+
+      //--dma-cost=N
+      if (regex_search(token, match, dma_cost_regex)) {
+        options.dma_cycles_per_word = std::stoul(match[1]);
+        continue;
+      }
+
+      //--unbuffered-terminal
+      if (token == "--unbuffered-terminal") {
+        options.unbuffered_terminal = true;
+        continue;
+      }
+
+      //--trace
+      if (token == "--trace") {
+        options.trace_option = true;
+        continue;
+      }
+
+      if (token.find("--") == 0 || !input_file_name.empty())
         throw InvalidEmulatorCmdArgs();
 
-    std::ifstream input_file(argv[1]);
+      input_file_name = token;
+    }
+
+    if (input_file_name.empty() && options.restore_file_name.empty() && options.fleet_file_name.empty())
+        throw InvalidEmulatorCmdArgs();
 
-    if (!input_file.is_open())
-        throw FileNameError(argv[1]);
+    //Fleet jobs are single core runs configured by the manifest
+    if (!options.fleet_file_name.empty() && (!input_file_name.empty() || options.core_count > 1 || options.snapshot_option
+        || !options.restore_file_name.empty() || !options.record_file_name.empty() || !options.replay_file_name.empty() || options.trace_option
+        || !options.profile_prefix.empty() || !options.sample_prefix.empty() || !options.disk_file_name.empty()))
+        throw InvalidEmulatorCmdArgs();
 
-    Emulator* emulator = new Emulator();
-    emulator->Emulate(input_file);
-    delete emulator;
+    if (!options.map_file_name.empty() && options.profile_prefix.empty() && options.sample_prefix.empty())
+        throw InvalidEmulatorCmdArgs();
 
-    input_file.close();
+    if (!options.record_file_name.empty() && !options.replay_file_name.empty())
+        throw InvalidEmulatorCmdArgs();
+
+    //Snapshots, journals and tracing describe a single core run
+    if (options.core_count > 1 && (options.snapshot_option || !options.restore_file_name.empty()
+        || !options.record_file_name.empty() || !options.replay_file_name.empty() || options.trace_option
+        || !options.profile_prefix.empty() || !options.sample_prefix.empty()))
+        throw InvalidEmulatorCmdArgs();
+
+    if (!options.fleet_file_name.empty()){
+        run_fleet(options);
+        return 0;
+    }
+
+    Image image(options.restore_file_name.empty() ? input_file_name : options.restore_file_name);
+    Memory memory(options.protect_option);
+    Bus bus;
+    std::vector<Emulator*> cores;
+    for (uint32_t i = 0; i < options.core_count; i++)
+        cores.push_back(new Emulator(options, memory, bus, i));
+
+    SmpController smp_controller(options.core_count, [&cores](uint32_t core_id, int interrupt_cause){
+        cores[core_id]->request_interrupt(interrupt_cause);
+    });
+    if (options.core_count > 1) bus.attach(SmpController::base, SmpController::size, &smp_controller);
+    for (Emulator* core : cores) core->attach_smp(&smp_controller);
+
+    Timer timer;
+    bus.attach(Timer::base, Timer::size, &timer);
+    cores[0]->attach_timer(&timer);
+
+    Terminal terminal(options.unbuffered_terminal);
+    bus.attach(Terminal::base, Terminal::size, &terminal);
+    cores[0]->attach_terminal(&terminal);
+
+    std::unique_ptr<BlockDevice> disk;
+    if (!options.disk_file_name.empty()){
+        disk.reset(new BlockDevice(options.disk_file_name, memory, [&cores](uint32_t core_id, int interrupt_cause){
+            cores[core_id]->request_interrupt(interrupt_cause);
+        }));
+        bus.attach(BlockDevice::base, BlockDevice::size, disk.get());
+    }
+
+    DmaController dma_controller(memory, options.dma_cycles_per_word, [&cores](uint32_t core_id, int interrupt_cause){
+        cores[core_id]->request_interrupt(interrupt_cause);
+    }, [&cores](uint32_t core_id, uint64_t cycles){
+        cores[core_id]->charge_cycles(cycles);
+    });
+    bus.attach(DmaController::base, DmaController::size, &dma_controller);
+
+    //The first core that exited with a nonzero status decides the exit status of the emulator
+    int exit_status = 0;
+    try{
+        cores[0]->load(image);
+
+        //All cores start at the same address, core 0 on this thread
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(cores.size());
+        for (uint32_t i = 1; i < cores.size(); i++)
+            threads.push_back(std::thread([&cores, &errors, i](){
+                try { cores[i]->run(); }
+                catch(...) { errors[i] = std::current_exception(); }
+            }));
+
+        try { cores[0]->run(); }
+        catch(...) { errors[0] = std::current_exception(); }
+
+        for (auto& thread : threads) thread.join();
+        for (auto& error : errors)
+            if (error) std::rethrow_exception(error);
+
+        for (uint32_t i = 0; i < cores.size(); i++){
+            if (cores.size() > 1) std::cout << "Core " << std::dec << i << ":\n";
+            cores[i]->write_output(std::cout);
+            if (cores[i]->exited() && exit_status == 0) exit_status = cores[i]->get_exit_status();
+        }
+    }
+    catch(...){
+        for (Emulator* core : cores) delete core;
+        throw;
+    }
+
+    for (Emulator* core : cores) delete core;
+    return exit_status;
   }
   catch(const std::exception& e) {
     std::cout << e.what() << '\n';
   }
 
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#include "../inc/HostCall.hpp"
+
+
+HostCall::HostCall(){
+  this->files = {stdin, stdout, stderr};
+}
+
+HostCall::~HostCall(){
+  for (size_t handle = 3; handle < this->files.size(); handle++)
+    if (this->files[handle] != nullptr) std::fclose(this->files[handle]);
+  this->flush();
+}
+
+
+FILE* HostCall::file(int handle) const{
+  if (handle < 0 || (size_t)handle >= this->files.size()) return nullptr;
+  return this->files[handle];
+}
+
+
+//Handles of closed files are reused
+int HostCall::open(const std::string& path, uint32_t mode){
+  static const char* modes[3] = {"rb", "wb", "ab"};
+  if (mode > 2) return -1;
+
+  FILE* file = std::fopen(path.c_str(), modes[mode]);
+  if (file == nullptr) return -1;
+
+  for (size_t handle = 3; handle < this->files.size(); handle++)
+    if (this->files[handle] == nullptr){
+      this->files[handle] = file;
+      return handle;
+    }
+
+  this->files.push_back(file);
+  return this->files.size() - 1;
+}
+
+int HostCall::close(int handle){
+  FILE* file = this->file(handle);
+  if (file == nullptr || handle < 3) return -1;
+
+  this->files[handle] = nullptr;
+  return std::fclose(file) == 0 ? 0 : -1;
+}
+
+
+int HostCall::read(int handle, uint8_t* buffer, uint32_t size){
+  FILE* file = this->file(handle);
+  if (file == nullptr) return -1;
+
+  size_t count = std::fread(buffer, 1, size, file);
+  if (count < size && std::ferror(file)) return -1;
+  return count;
+}
+
+int HostCall::write(int handle, const uint8_t* data, uint32_t size){
+  FILE* file = this->file(handle);
+  if (file == nullptr) return -1;
+
+  size_t count = std::fwrite(data, 1, size, file);
+  if (count < size) return -1;
+  return count;
+}
+
+
+void HostCall::flush(){
+  std::fflush(stdout);
+  std::fflush(stderr);
+}
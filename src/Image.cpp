@@ -0,0 +1,169 @@
+#include "../inc/Image.hpp"
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+static uint32_t image_word(const uint8_t* data, size_t offset){
+  const uint8_t* bytes = data + offset;
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+Image::Image(const std::string& file_name): file_name(file_name){
+  std::ifstream input_file(file_name, std::ios::binary);
+  if (!input_file.is_open())
+    throw FileNameError(file_name);
+
+  //Hex text or paged binary image
+  char magic[4] = {0};
+  input_file.read(magic, 4);
+  input_file.clear();
+  input_file.seekg(0);
+
+  if (std::memcmp(magic, PagedImage::magic, 4) == 0){
+    input_file.close();
+    this->parse_paged();
+  }
+  else
+    this->parse_hex(input_file);
+}
+
+
+Image::~Image(){
+#ifndef _WIN32
+  if (this->host_fd >= 0) close(this->host_fd);
+#endif
+}
+
+
+void Image::parse_hex(std::istream& input_file){
+  std::string line;
+  std::string data;
+  uint32_t address = 0;
+
+  while (getline(input_file, line)){
+    //empty line
+    if (line.empty() || line.find_first_not_of(' ') == std::string::npos) continue;
+
+    std::stringstream ss(line);
+
+    //Read address
+    ss>>data;
+    data.pop_back();
+    address = stoull("0x"+data, nullptr, 16);
+
+    while (ss >> data){
+      try{
+        std::vector<uint8_t>& page = this->hex_pages[address / PagedImage::page_size];
+        if (page.empty()) page.resize(PagedImage::page_size, 0);
+
+        page[address % PagedImage::page_size] = (uint8_t)stoi(data, nullptr, 16);
+      }
+      catch (const std::exception& e) {}
+
+      address++;
+    }
+  }
+
+  this->move_hex_pages_to_host_file();
+
+  //No host file - instances share the parsed pages
+  for (auto& page : this->hex_pages)
+    this->page_map[page.first] = page.second.data();
+}
+
+
+//Parsed pages are written one after another into a memfd and read back through a read-only mapping
+void Image::move_hex_pages_to_host_file(){
+#if !defined(_WIN32) && defined(MFD_CLOEXEC)
+  int fd = memfd_create("emulator_image", MFD_CLOEXEC);
+  if (fd < 0) return;
+
+  size_t offset = 0;
+  for (auto& page : this->hex_pages){
+    if (write(fd, page.second.data(), PagedImage::page_size) != (ssize_t)PagedImage::page_size){
+      close(fd);
+      this->page_offset_map.clear();
+      return;
+    }
+    this->page_offset_map[page.first] = offset;
+    offset += PagedImage::page_size;
+  }
+
+  this->host_fd = fd;
+  this->host_size = offset;
+  this->file.reset(new MappedFile(fd, offset, this->file_name, MappedFile::READ_ONLY));
+
+  for (auto& page : this->page_offset_map)
+    this->page_map[page.first] = this->file->data() + page.second;
+
+  this->hex_pages.clear();
+#endif
+}
+
+
+//Pages are used in place from the mapped file
+void Image::parse_paged(){
+  this->file.reset(new MappedFile(this->file_name));
+  const uint8_t* data = this->file->data();
+
+  if (this->file->size() < PagedImage::header_words * 4 || std::memcmp(data, PagedImage::magic, 4) != 0
+    || image_word(data, 4) != PagedImage::version || image_word(data, 8) != PagedImage::page_size)
+    throw InvalidImageError(this->file_name);
+
+  uint32_t page_count = image_word(data, 12);
+  uint32_t state_count = image_word(data, 16);
+
+  size_t state_offset = PagedImage::header_words * 4;
+  size_t page_numbers_offset = state_offset + (size_t)state_count * 8;
+  size_t pages_offset = (page_numbers_offset + (size_t)page_count * 4 + PagedImage::page_size - 1) / PagedImage::page_size * PagedImage::page_size;
+
+  if (pages_offset + (size_t)page_count * PagedImage::page_size > this->file->size())
+    throw InvalidImageError(this->file_name);
+
+  for (uint32_t i = 0; i < page_count; i++){
+    uint32_t page_number = image_word(data, page_numbers_offset + i * 4);
+    this->page_offset_map[page_number] = pages_offset + (size_t)i * PagedImage::page_size;
+    this->page_map[page_number] = data + this->page_offset_map[page_number];
+  }
+
+  //Private views map the image file itself
+#ifndef _WIN32
+  this->host_fd = open(this->file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  this->host_size = this->file->size();
+#endif
+
+  for (uint32_t i = 0; i < state_count; i++)
+    this->state_words.push_back({image_word(data, state_offset + i * 8), image_word(data, state_offset + i * 8 + 4)});
+}
+
+
+std::unique_ptr<MappedFile> Image::private_view() const{
+#ifndef _WIN32
+  if (this->host_fd >= 0)
+    return std::unique_ptr<MappedFile>(new MappedFile(this->host_fd, this->host_size, this->file_name, MappedFile::COPY_ON_WRITE));
+#endif
+  return nullptr;
+}
+
+const std::map<uint32_t, size_t>& Image::page_offsets() const{
+  return this->page_offset_map;
+}
+
+
+const std::map<uint32_t, const uint8_t*>& Image::pages() const{
+  return this->page_map;
+}
+
+const std::vector<std::pair<uint32_t, uint32_t>>& Image::state() const{
+  return this->state_words;
+}
+
+const std::string& Image::name() const{
+  return this->file_name;
+}
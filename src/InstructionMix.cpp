@@ -0,0 +1,101 @@
+#include "../inc/InstructionMix.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+
+InstructionMix::InstructionMix(const std::map<uint8_t, std::string>& op_code_names): op_code_names(op_code_names){
+  if (op_code_names.size() > index_mask)
+    throw std::length_error("Instruction mix: too many op codes for the dense index");
+
+  this->index_op_code.push_back(0);
+  for (auto& op_code : op_code_names){
+    this->op_code_index[op_code.first] = this->index_op_code.size();
+    this->index_op_code.push_back(op_code.first);
+  }
+
+  this->triple_counts.assign(triple_mask + 1, 0);
+}
+
+
+//Sequences of the last length op codes of every counted triple
+std::vector<InstructionMix::Sequence> InstructionMix::sequences(int length) const{
+  std::map<uint32_t, uint64_t> counts;
+
+  for (uint32_t triple = 0; triple <= triple_mask; triple++){
+    if (!this->triple_counts[triple]) continue;
+
+    bool complete = true;
+    for (int i = 0; i < length; i++)
+      if (((triple >> (i * index_bits)) & index_mask) == 0) complete = false;
+    if (!complete) continue;
+
+    counts[triple & ((1u << length * index_bits) - 1)] += this->triple_counts[triple];
+  }
+
+  std::vector<Sequence> result;
+  for (auto& count : counts){
+    Sequence sequence;
+    for (int i = length - 1; i >= 0; i--)
+      sequence.op_codes.push_back(this->index_op_code[(count.first >> (i * index_bits)) & index_mask]);
+    sequence.count = count.second;
+    result.push_back(sequence);
+  }
+
+  std::stable_sort(result.begin(), result.end(), [](const Sequence& a, const Sequence& b){ return a.count > b.count; });
+  return result;
+}
+
+
+static std::string op_code_string(uint8_t op_code){
+  std::stringstream ss;
+  ss << "0x" << std::hex << std::setw(2) << std::setfill('0') << (int)op_code;
+  return ss.str();
+}
+
+
+void InstructionMix::write(const std::string& prefix) const{
+  const char* kinds[3] = {"op_code", "pair", "triple"};
+  std::vector<Sequence> tables[3] = {this->sequences(1), this->sequences(2), this->sequences(3)};
+
+  uint64_t total = 0;
+  for (auto& sequence : tables[0]) total += sequence.count;
+
+  std::ofstream csv_file(prefix + ".csv");
+  if (!csv_file.is_open())
+    throw FileNameError(prefix + ".csv");
+
+  csv_file << "kind,op_codes,instructions,count,percent\n";
+  for (int kind = 0; kind < 3; kind++)
+    for (auto& sequence : tables[kind]){
+      std::string op_codes, names;
+      for (size_t i = 0; i < sequence.op_codes.size(); i++){
+        op_codes += (i ? " " : "") + op_code_string(sequence.op_codes[i]);
+        names += (i ? " " : "") + this->op_code_names.at(sequence.op_codes[i]);
+      }
+      csv_file << kinds[kind] << "," << op_codes << "," << names << "," << std::dec << sequence.count << ","
+        << std::fixed << std::setprecision(4) << 100.0 * sequence.count / total << "\n";
+    }
+
+  std::ofstream json_file(prefix + ".json");
+  if (!json_file.is_open())
+    throw FileNameError(prefix + ".json");
+
+  json_file << "{\n  \"instructions\": " << std::dec << total;
+  for (int kind = 0; kind < 3; kind++){
+    json_file << ",\n  \"" << kinds[kind] << "s\": [";
+    for (size_t j = 0; j < tables[kind].size(); j++){
+      const Sequence& sequence = tables[kind][j];
+      std::string op_codes, names;
+      for (size_t i = 0; i < sequence.op_codes.size(); i++){
+        op_codes += std::string(i ? ", " : "") + "\"" + op_code_string(sequence.op_codes[i]) + "\"";
+        names += std::string(i ? ", " : "") + "\"" + this->op_code_names.at(sequence.op_codes[i]) + "\"";
+      }
+      json_file << (j ? "," : "") << "\n    {\"op_codes\": [" << op_codes << "], \"instructions\": [" << names << "], \"count\": " << sequence.count << "}";
+    }
+    json_file << "\n  ]";
+  }
+  json_file << "\n}\n";
+}
@@ -0,0 +1,35 @@
+#include "../inc/InterruptController.hpp"
+
+
+uint32_t InterruptController::enabled(int status){
+  if (status & 0x4) return 0;
+
+  uint32_t mask = ~attention;
+  if (status & 0x1) mask &= ~(1u << 2);
+  if (status & 0x2) mask &= ~(1u << 3);
+  return mask;
+}
+
+
+bool InterruptController::take_attention(){
+  if (!(this->pending.load(std::memory_order_relaxed) & attention)) return false;
+
+  this->pending.fetch_and(~attention, std::memory_order_relaxed);
+  return true;
+}
+
+
+//Only the owning core clears causes, a raise between the load and the clear stays pending
+int InterruptController::take(int status){
+  uint32_t pending = this->pending.load(std::memory_order_relaxed) & enabled(status);
+  if (pending == 0) return -1;
+
+  int cause = __builtin_ctz(pending);
+  this->pending.fetch_and(~(1u << cause), std::memory_order_acquire);
+  return cause;
+}
+
+
+std::atomic<uint32_t>& InterruptController::word(){
+  return this->pending;
+}
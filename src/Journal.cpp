@@ -0,0 +1,75 @@
+#include "../inc/Journal.hpp"
+#include <cstring>
+
+
+static const char journal_magic[4] = {'S', 'S', 'J', 'R'};
+static const uint32_t journal_version = 1;
+
+
+static uint32_t journal_word(const uint8_t* data, size_t offset){
+  const uint8_t* bytes = data + offset;
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+Journal::Journal(const std::string& file_name, Mode mode): journal_mode(mode){
+  if (mode == Mode::RECORD){
+    this->output_file.reset(new OutputWriter(file_name, 1 << 16));
+    this->output_file->write_bytes(journal_magic, 4);
+    this->output_file->write_word(journal_version);
+    return;
+  }
+
+  this->input_file.reset(new MappedFile(file_name));
+  if (this->input_file->size() < header_words * 4 || std::memcmp(this->input_file->data(), journal_magic, 4) != 0
+    || journal_word(this->input_file->data(), 4) != journal_version)
+    throw InvalidJournalError(file_name);
+
+  this->read_offset = header_words * 4;
+  this->read_entry();
+}
+
+
+void Journal::record(const Journal_entry& entry){
+  this->output_file->write_word((uint32_t)entry.event);
+  this->output_file->write_word((uint32_t)entry.instruction_count);
+  this->output_file->write_word((uint32_t)(entry.instruction_count >> 32));
+  this->output_file->write_word(entry.source);
+  this->output_file->write_word(entry.value);
+}
+
+
+const Journal_entry* Journal::peek() const{
+  return this->has_next ? &this->next_entry : nullptr;
+}
+
+Journal_entry Journal::next(){
+  if (!this->has_next)
+    throw ReplayDivergenceError("journal ended");
+
+  Journal_entry entry = this->next_entry;
+  this->read_entry();
+  return entry;
+}
+
+
+void Journal::read_entry(){
+  const uint8_t* data = this->input_file->data();
+  this->has_next = this->read_offset + entry_words * 4 <= this->input_file->size();
+  if (!this->has_next) return;
+
+  this->next_entry.event = (Journal_event)journal_word(data, this->read_offset);
+  this->next_entry.instruction_count = journal_word(data, this->read_offset + 4) | ((uint64_t)journal_word(data, this->read_offset + 8) << 32);
+  this->next_entry.source = journal_word(data, this->read_offset + 12);
+  this->next_entry.value = journal_word(data, this->read_offset + 16);
+  this->read_offset += entry_words * 4;
+}
+
+
+void Journal::close(){
+  if (this->output_file) this->output_file->close();
+}
+
+Journal::Mode Journal::mode() const{
+  return this->journal_mode;
+}
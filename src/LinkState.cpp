@@ -0,0 +1,118 @@
+#include "../inc/LinkState.hpp"
+
+
+enum class LinkStateReadingType {
+    NONE,
+    INPUTS,
+    PLACES,
+    SECTIONS,
+    SYMBOLS,
+    IMPORTS
+};
+
+
+//Returns false when there is no usable state file
+bool Link_state::load(const std::string& file_name){
+  std::ifstream input_file(file_name);
+  if (!input_file.is_open()) return false;
+
+  std::string line;
+  if (!getline(input_file, line) || line != "Link state") return false;
+
+  LinkStateReadingType currentType = LinkStateReadingType::NONE;
+  while (getline(input_file, line)){
+    if (line.empty() || line.find_first_not_of(' ') == std::string::npos) continue;
+
+    std::istringstream iss(line);
+    std::string token;
+    iss >> token;
+
+    if (token == "Output") { iss >> this->output_file_name >> this->output_format; continue; }
+    if (token == "Inputs") { currentType = LinkStateReadingType::INPUTS; continue; }
+    if (token == "Places") { currentType = LinkStateReadingType::PLACES; continue; }
+    if (token == "Sections") { currentType = LinkStateReadingType::SECTIONS; continue; }
+    if (token == "Symbols") { currentType = LinkStateReadingType::SYMBOLS; continue; }
+    if (token == "Imports") { currentType = LinkStateReadingType::IMPORTS; continue; }
+
+    iss.clear();
+    iss.str(line);
+
+    switch (currentType){
+    case LinkStateReadingType::INPUTS: {
+      std::string input_file_name;
+      uint64_t hash;
+      if (!(iss >> input_file_name >> std::hex >> hash)) return false;
+      this->input_file_names.push_back(input_file_name);
+      this->object_hashes[input_file_name] = hash;
+      break;
+    }
+    case LinkStateReadingType::PLACES: {
+      std::string section_name;
+      uint64_t location;
+      if (!(iss >> section_name >> std::hex >> location)) return false;
+      this->section_places[section_name] = location;
+      break;
+    }
+    case LinkStateReadingType::SECTIONS: {
+      Section_slot slot;
+      if (!(iss >> slot.file_name >> slot.section_name >> std::hex >> slot.location >> std::dec >> slot.size >> slot.output_offset)) return false;
+      this->sections.push_back(slot);
+      break;
+    }
+    case LinkStateReadingType::SYMBOLS: {
+      std::string symbol_name, defining_file;
+      uint32_t address;
+      if (!(iss >> symbol_name >> std::hex >> address >> defining_file)) return false;
+      this->symbols[symbol_name] = std::make_pair(address, defining_file);
+      break;
+    }
+    case LinkStateReadingType::IMPORTS: {
+      Import_site site;
+      if (!(iss >> site.file_name >> site.section_name >> std::dec >> site.location >> site.symbol_name)) return false;
+      this->imports.push_back(site);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void Link_state::save(const std::string& file_name) const{
+  std::ofstream output_file(file_name);
+
+  output_file << "Link state\n";
+  output_file << "Output " << this->output_file_name << " " << this->output_format << "\n";
+
+  output_file << "Inputs\n";
+  for (auto& input_file_name : this->input_file_names)
+    output_file << input_file_name << " " << std::hex << this->object_hashes.at(input_file_name) << "\n";
+
+  output_file << "Places\n";
+  for (auto& place : this->section_places)
+    output_file << place.first << " " << std::hex << place.second << "\n";
+
+  output_file << "Sections\n";
+  for (auto& slot : this->sections)
+    output_file << slot.file_name << " " << slot.section_name << " " << std::hex << slot.location << " "
+      << std::dec << slot.size << " " << slot.output_offset << "\n";
+
+  output_file << "Symbols\n";
+  for (auto& symbol : this->symbols)
+    output_file << symbol.first << " " << std::hex << symbol.second.first << " " << symbol.second.second << "\n";
+
+  output_file << "Imports\n";
+  for (auto& site : this->imports)
+    output_file << site.file_name << " " << site.section_name << " " << std::dec << site.location << " " << site.symbol_name << "\n";
+}
+
+
+Link_state::Section_slot* Link_state::get_slot(const std::string& file_name, const std::string& section_name){
+  for (auto& slot : this->sections)
+    if (slot.file_name == file_name && slot.section_name == section_name) return &slot;
+
+  return nullptr;
+}
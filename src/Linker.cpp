@@ -1,11 +1,51 @@
 #include "../inc/Linker.hpp"
 
 
-std::ofstream Linker::log_file("linker.log");
+std::ofstream Linker::log_file;
 
 
+//FNV-1a, stable across runs and platforms so folding decisions are deterministic
+static uint64_t fnv1a(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL){
+  for (size_t i = 0; i < size; i++){
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+
+static void patch_word(std::vector<uint8_t>& code, uint32_t location, uint32_t value){
+  code[location] = ((value & 0xFF000000) >> 3*8);
+  code[location + 1] = ((value & 0x00FF0000) >> 2*8);
+  code[location + 2] = ((value & 0x0000FF00) >> 1*8);
+  code[location + 3] = value & 0x000000FF;
+}
+
+
+static uint64_t hash_file(const std::string& file_name){
+  std::ifstream input_file(file_name, std::ios::binary);
+  if (!input_file.is_open())
+    throw FileNameError(file_name);
+
+  std::vector<char> buffer(1 << 16);
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  while (input_file.read(buffer.data(), buffer.size()) || input_file.gcount() > 0)
+    hash = fnv1a(reinterpret_cast<const uint8_t*>(buffer.data()), input_file.gcount(), hash);
+
+  return hash;
+}
 
-Linker::Linker(bool hex_option, std::map<std::string, uint64_t> section_places): hex_option(hex_option), section_places(section_places){}
+
+
+Linker::Linker(Linker_options options): hex_option(options.hex_option), binary_option(options.binary_option), icf_option(options.icf_option),
+  state_file_name(options.state_file_name), section_places(options.section_places), requested_section_places(options.section_places),
+  library_file_names(options.library_file_names), log_option(options.log_option), map_file_name(options.map_file_name),
+  thread_pool(options.thread_count){
+
+  //Opened only when logging, so --no-log leaves an existing log alone. Writes to a failed stream are dropped
+  if(this->log_option) this->log_file.open("linker.log");
+  else this->log_file.setstate(std::ios::badbit);
+}
 
 Linker::~Linker(){
   this->log_file.close();
@@ -15,7 +55,6 @@ Linker::~Linker(){
 void Linker::decompose_input_files(std::vector<std::string> input_file_names){
 
   std::ifstream input_file;
-  std::string line;
 
   for(std::string file_name : input_file_names){
     input_file = std::ifstream(file_name);
@@ -23,7 +62,22 @@ void Linker::decompose_input_files(std::vector<std::string> input_file_names){
     if (!input_file.is_open())
       throw FileNameError(file_name);
 
+    this->decompose_object_file(file_name, input_file);
 
+    input_file.close();
+  }
+
+  // DEBUGGING:
+  // this->log_file<<object_files.at("./tests/javni_test/main.o").symbol_table;
+  // this->log_file<<object_files.at("./tests/javni_test/main.o").sections.at("my_code");
+  // this->log_file<<object_files.at("./tests/javni_test/main.o").relocation_table;
+  
+}
+
+
+//Object file contents may come from a file or from a library archive member
+void Linker::decompose_object_file(std::string file_name, std::istream& input_file){
+    std::string line;
 
     object_files.insert({file_name, Object_file(file_name)});
     object_files_order.push_back(file_name);               //push file_name in order list
@@ -102,23 +156,20 @@ void Linker::decompose_input_files(std::vector<std::string> input_file_names){
 
 
     }
-    
-
-    input_file.close();
-  }
-
-  // DEBUGGING:
-  // this->log_file<<object_files.at("./tests/javni_test/main.o").symbol_table;
-  // this->log_file<<object_files.at("./tests/javni_test/main.o").sections.at("my_code");
-  // this->log_file<<object_files.at("./tests/javni_test/main.o").relocation_table;
-  
 }
 
 
 
 void Linker::fill_symbol_table() {
 
-  for (std::string object_file_name : this->object_files_order){
+  for (std::string object_file_name : this->object_files_order)
+    this->add_object_symbols(object_file_name);
+
+  if (!this->library_file_names.empty()) this->load_library_members();
+}
+
+
+void Linker::add_object_symbols(std::string object_file_name) {
     Object_file* object_file = &this->object_files.at(object_file_name);
 
 
@@ -164,8 +215,62 @@ void Linker::fill_symbol_table() {
       }
 
     }
+}
+
 
+//Pulls in library members that define currently undefined symbols, until no more can be resolved.
+//Libraries are searched in command line order, every member is loaded at most once.
+void Linker::load_library_members() {
+  std::vector<Archive*> libraries;
+  for (std::string library_file_name : this->library_file_names)
+    libraries.push_back(new Archive(library_file_name));
+
+  std::set<std::pair<size_t, int>> loaded_members;       //library index, member index
+
+  try{
+    bool progress = true;
+    while (progress){
+      progress = false;
+
+      std::vector<std::string> undefined_symbols;
+      for(auto& it: this->linker_symbol_table.table)
+        if (it.second->is_extern) undefined_symbols.push_back(it.first);
+
+      for (std::string symbol_name : undefined_symbols){
+        Symbol* symbol = this->linker_symbol_table.get_symbol_by_name(symbol_name);
+        if (!symbol->is_extern) continue;           //defined by a member loaded in this round
+
+        for (size_t i = 0; i < libraries.size(); i++){
+          int member = libraries[i]->find_member(symbol_name);
+          if (member < 0 || !loaded_members.insert(std::make_pair(i, member)).second) continue;
+
+          //Members from different directories may share a name, the member index keeps their object files apart
+          std::string member_name = libraries[i]->member_name(member);
+          for (uint32_t other = 0; other < libraries[i]->member_count(); other++)
+            if (other != (uint32_t)member && libraries[i]->member_name(other) == member_name){
+              member_name += "#" + std::to_string(member);
+              break;
+            }
+
+          std::string member_file_name = libraries[i]->name() + "(" + member_name + ")";
+          std::istringstream member_data(libraries[i]->member_data(member));
+
+          this->log_file << "Loading " << member_file_name << " for symbol " << symbol_name << "\n";
+          this->decompose_object_file(member_file_name, member_data);
+          this->add_object_symbols(member_file_name);
+
+          progress = true;
+          break;
+        }
+      }
+    }
+  }
+  catch(...){
+    for (Archive* library : libraries) delete library;
+    throw;
   }
+
+  for (Archive* library : libraries) delete library;
 }
 
 
@@ -182,6 +287,19 @@ void Linker::undefined_symbol_check(){
 void Linker::Link(std::vector<std::string> input_file_names, std::string output_file_name){
 
   try{
+      //Folding decisions, library member selection and the symbol map depend on all objects, so such links are always full links
+      bool incremental = !this->state_file_name.empty() && !this->icf_option && this->library_file_names.empty() && this->map_file_name.empty();
+      if(incremental){
+        if(this->incremental_link(input_file_names, output_file_name)){
+          std::cout<<"Linking succeed!\n";
+          return;
+        }
+
+        //Previous layout can not be reused - start over
+        this->object_files.clear();
+        this->object_files_order.clear();
+      }
+
       this->log_file << "Loading input files started:\n\n";
       this->decompose_input_files(input_file_names);
 
@@ -203,22 +321,31 @@ void Linker::Link(std::vector<std::string> input_file_names, std::string output_
       
       this->undefined_symbol_check();
 
+      if(this->icf_option) this->fold_identical_sections();
+
       this->formSections();
 
       this->check_sections_overlapping();
 
       this->resolve_relocations();
 
+      this->apply_relocations();
+
       this->log_file << "\n\nWriting Output File:\n";
-      std::ofstream output_file(output_file_name);
+      OutputWriter output_file(output_file_name);
 
       //WRITE OUTPUT FILE
       if(this->hex_option) this->write_output_file(output_file);
+      else if(this->binary_option) this->write_binary_output_file(output_file);
 
 
       output_file.close();
       this->log_file << "Writing Output File completed\n";
 
+      if(!this->map_file_name.empty()) this->write_symbol_map();
+
+      if(incremental) this->save_link_state(input_file_names, output_file_name);
+
       std::cout<<"Linking succeed!\n";
   }
   catch(std::exception& e)
@@ -229,6 +356,121 @@ void Linker::Link(std::vector<std::string> input_file_names, std::string output_
 }
 
 
+//Section candidate for identical code folding
+struct Icf_section{
+  std::string file_name;
+  Section* section;
+  std::vector<std::string> relocation_targets;     //"location target" for each relocation inside the section
+  uint64_t hash = 0;
+  bool foldable = true;
+};
+
+
+//Sections with the same code bytes and the same relocation targets are merged into the first one in link order.
+//References inside the section itself are compared by offset, so two copies of the same local code are identical.
+//Sections with -place attribute and sections referenced other than as jump or call targets are never folded,
+//their address may be loaded or used as data.
+void Linker::fold_identical_sections(){
+  std::vector<Icf_section> candidates;
+  std::map<std::pair<std::string, std::string>, size_t> candidate_index;    //section_name, file_name
+
+  for (std::string object_file_name : this->object_files_order){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+    for(auto it: object_file->sections_order){
+      Icf_section candidate;
+      candidate.file_name = object_file_name;
+      candidate.section = &object_file->sections.at(it);
+      candidate.foldable = this->section_places.find(it) == this->section_places.end();
+
+      candidate_index.insert({std::make_pair(it, object_file_name), candidates.size()});
+      candidates.push_back(candidate);
+    }
+  }
+
+
+  //Hash each section with its relocation targets - independent work, one candidate per task
+  this->thread_pool.parallel_for(candidates.size(), [&](size_t i){
+    Icf_section& candidate = candidates[i];
+    Object_file* object_file = &this->object_files.at(candidate.file_name);
+    std::vector<std::pair<uint32_t, std::string>> targets;
+
+    for(auto it: object_file->relocation_table.table){
+      Relocation* relocation = it.second;
+      if(relocation->section_name != candidate.section->name) continue;
+
+      //Target of the relocation: file, section and offset of the symbol
+      Symbol* symbol = object_file->symbol_table.get_symbol_by_name(relocation->symbol_name);
+      std::string target_file = candidate.file_name;
+      if(!symbol->defined){
+        symbol = this->linker_symbol_table.get_symbol_by_name(symbol->name);
+        target_file = symbol->file_name;
+      }
+
+      std::string target;
+      if(target_file == candidate.file_name && symbol->section_name == candidate.section->name)
+        target = "SELF " + std::to_string(symbol->value);
+      else
+        target = target_file + " " + symbol->section_name + " " + std::to_string(symbol->value);
+
+      targets.push_back({relocation->location, target});
+    }
+
+    std::sort(targets.begin(), targets.end());
+
+    uint64_t hash = fnv1a(candidate.section->section_code.data(), candidate.section->section_code.size());
+    for(auto& target : targets){
+      candidate.relocation_targets.push_back(std::to_string(target.first) + " " + target.second);
+      hash = fnv1a(reinterpret_cast<const uint8_t*>(candidate.relocation_targets.back().data()), candidate.relocation_targets.back().size(), hash);
+    }
+    candidate.hash = hash;
+  });
+
+
+  //Only jump and call targets prove a section holds code. Loaded addresses, memory operands and .word values
+  //may name data - folding it would merge distinct variables
+  for (std::string object_file_name : this->object_files_order){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+    for(auto it: object_file->relocation_table.table){
+      Relocation* relocation = it.second;
+      if(relocation->type_of_relocation == Usage_type::SYMBOL_JUMP) continue;
+
+      Symbol* symbol = object_file->symbol_table.get_symbol_by_name(relocation->symbol_name);
+      std::string target_file = object_file_name;
+      if(!symbol->defined){
+        symbol = this->linker_symbol_table.get_symbol_by_name(symbol->name);
+        target_file = symbol->file_name;
+      }
+
+      auto target = candidate_index.find(std::make_pair(symbol->section_name, target_file));
+      if(target != candidate_index.end()) candidates[target->second].foldable = false;
+    }
+  }
+
+
+  //Grouping runs in link order, so the surviving copy is always the first identical section
+  std::unordered_map<uint64_t, std::vector<size_t>> survivors;
+  for(size_t i = 0; i < candidates.size(); i++){
+    Icf_section& candidate = candidates[i];
+    if(!candidate.foldable) continue;
+
+    bool folded = false;
+    for(size_t j : survivors[candidate.hash]){
+      Icf_section& survivor = candidates[j];
+
+      if(survivor.section->section_code == candidate.section->section_code && survivor.relocation_targets == candidate.relocation_targets){
+        candidate.section->folded_into = survivor.section;
+        this->log_file << "ICF: folded " << candidate.section->name << " (" << candidate.file_name << ") into "
+          << survivor.section->name << " (" << survivor.file_name << ")\n";
+        folded = true;
+        break;
+      }
+    }
+
+    if(!folded) survivors[candidate.hash].push_back(i);
+  }
+}
+
+
 
 void Linker::formSections(){
 
@@ -296,7 +538,7 @@ void Linker::formSections(){
     for(auto it: object_file->sections_order){
       Section& section = object_file->sections.at(it);
 
-      if(!section.placed){
+      if(!section.placed && section.folded_into == nullptr){
         section.location = placing_location;  //write section location and place it
         section.placed = true;
         this->linker_sections.at(std::make_pair(section.name, object_file_name))->value = placing_location;
@@ -307,6 +549,20 @@ void Linker::formSections(){
     }
   }
 
+  //Folded sections share the location of their surviving copy
+  for (std::string object_file_name : this->object_files_order){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+    for(auto it: object_file->sections_order){
+      Section& section = object_file->sections.at(it);
+
+      if(section.folded_into != nullptr){
+        section.location = section.folded_into->location;
+        section.placed = true;
+        this->linker_sections.at(std::make_pair(section.name, object_file_name))->value = section.location;
+      }
+    }
+  }
+
 
   //Fill the output sections references
   this->log_file<<"\nSECTION ORDER\n";
@@ -315,6 +571,7 @@ void Linker::formSections(){
     for(auto it: object_file->sections_order){
       Section* section = &object_file->sections.at(it);
       this->log_file<<it<<" "<<std::dec<<section->section_code.size()<<" "<<std::hex<<section->location<<std::endl;
+      if(section->folded_into != nullptr) continue;     //only the surviving copy is written to the output
       
       this->output_sections.insert({std::make_pair(section->name, object_file_name), section});
       this->output_sections_order.push_back(std::make_pair(section->name, object_file_name));  //push full section naming data in order list
@@ -365,7 +622,7 @@ void Linker::check_sections_overlapping(){
           // std::cout<<sec1.name<<" "<<sec2.name<<std::endl;
           //PAIRS sec1, sec2 
 
-          if (sec1.placed && sec2.placed && sec1.name != sec2.name) {
+          if (sec1.placed && sec2.placed && sec1.name != sec2.name && sec1.folded_into == nullptr && sec2.folded_into == nullptr) {
             if (inside(sec2.location, sec1.location, sec1.location + sec1.section_code.size()) ||
             inside(sec2.location + sec2.section_code.size(), sec1.location, sec1.location + sec1.section_code.size()))
               throw SectionsOverlapError(sec1.name, sec2.name);
@@ -379,97 +636,374 @@ void Linker::check_sections_overlapping(){
 }
 
 
+//Computes final values of all relocations. Sections are patched afterwards in apply_relocations
 void Linker::resolve_relocations(){
+  //Log is formatted only when enabled and written at once
+  std::ostringstream log;
+
   //DEBUG INFO
-  this->log_file<<"\n\nRELOCATION ENTRIES:\n";
-  for (std::string object_file_name : this->object_files_order){
-    Object_file* object_file = &this->object_files.at(object_file_name);
-    this->log_file<<object_file->name<<std::endl;
-    this->log_file<<object_file->relocation_table;
+  if(this->log_option){
+    log<<"\n\nRELOCATION ENTRIES:\n";
+    for (std::string object_file_name : this->object_files_order){
+      Object_file* object_file = &this->object_files.at(object_file_name);
+      log<<object_file->name<<'\n';
+      log<<object_file->relocation_table;
+    }
+
+    log<<"\n\nRELOCATION SYMBOLS\n";
   }
 
-  this->log_file<<"\n\nRELOCATION SYMBOLS\n";
   for (std::string object_file_name : this->object_files_order){
     Object_file* object_file = &this->object_files.at(object_file_name);
     for(auto it: object_file->relocation_table.table){
       Relocation* relocation = it.second;
 
       Symbol* symbol = object_file->symbol_table.get_symbol_by_name(relocation->symbol_name);
-      
-      if(symbol->defined){
+      bool locally_defined = symbol->defined;
+      uint32_t symbol_val;
+
+      if(locally_defined){
         //Symbol is locally defined
+        symbol_val = symbol->value + object_file->sections.at(symbol->section_name).location;
+      }
+      else{
+        //Symbol is in global linker table
+        symbol = this->linker_symbol_table.get_symbol_by_name(symbol->name);
 
-        //RELOCATE
+        Symbol* section_symbol = this->linker_sections.at(std::make_pair(symbol->section_name, symbol->file_name));
+        symbol_val = symbol->value + section_symbol->value;
+      }
 
-        //TEST!!!!!!!!!!
-        Section& section = object_file->sections.at(symbol->section_name);
-        uint32_t symbol_val = symbol->value + section.location;   
+      //Get section where symbol is used - written in relocation entry
+      Section& section = object_file->sections.at(relocation->section_name);
+      this->relocation_patches[&section].push_back({relocation->location, symbol_val});
 
-        //Iterate through the relocation entries and correct the machine code
-        for (auto r : object_file->relocation_table.get_relocations(symbol->name)) {
-          //Get section where symbol is used - written in relocation entry
-          Section& section = object_file->sections.at(r->section_name);
+      if(this->log_option){
+        log<<(locally_defined ? "DEFINED SYMBOL " : "LOCALLY UNDEFINED SYMBOL ")<<'\n';
+        log<<*symbol;
+        log<<section.name<<" "<<section.location<<"\n\n";
+      }
+    }
+  }
 
-          this->log_file<<"DEFINED SYMBOL "<<std::endl;
-          this->log_file<<*symbol;
-          this->log_file<<section.name<<" "<<section.location<<std::endl<<std::endl;
-          // std::cout<<object_file_name<<" "<<r->symbol_name<<" "<<r->location<<" "<<section.section_code.size()<<std::endl;
-          
-          section.section_code[r->location] = ((symbol_val & 0xFF000000) >> 3*8);
-          section.section_code[r->location + 1] = ((symbol_val & 0x00FF0000) >> 2*8);
-          section.section_code[r->location + 2] = ((symbol_val & 0x0000FF00) >> 1*8);
-          section.section_code[r->location + 3] = symbol_val & 0x000000FF;
-        }
+  if(this->log_option) this->log_file<<log.str();
+}
 
 
-      }
-      else{
-        //Symbol is in global linker table
-        symbol = this->linker_symbol_table.get_symbol_by_name(symbol->name);
-        
+//Patches are independent between sections, each section is patched by one task
+void Linker::apply_relocations(){
+  std::vector<std::pair<Section* const, std::vector<Relocation_patch>>*> sections;
+  for(auto& it : this->relocation_patches) sections.push_back(&it);
 
-        //RELLOCATE 
+  this->thread_pool.parallel_for(sections.size(), [&sections](size_t i){
+    std::vector<uint8_t>& code = sections[i]->first->section_code;
+    for(const Relocation_patch& patch : sections[i]->second)
+      patch_word(code, patch.location, patch.value);
+  });
 
-        //TEST!!!!!!!
-        Symbol* section_symbol = this->linker_sections.at(std::make_pair(symbol->section_name, symbol->file_name));
-        uint32_t symbol_val = symbol->value + section_symbol->value; 
+  this->relocation_patches.clear();
+}
 
 
-        for (auto r : object_file->relocation_table.get_relocations(symbol->name)) {
-          //Get section where symbol is used - written in relocation entry
-          Section& section = object_file->sections.at(r->section_name);
+//Address of every label, sorted by address: "0xADDRESS name file". Used by the emulator profiler.
+void Linker::write_symbol_map(){
+  std::vector<std::pair<uint32_t, std::string>> symbols;
 
-          this->log_file<<"LOCALLY UNDEFINED SYMBOL "<<std::endl;
-          this->log_file<<*symbol;
-          this->log_file<<section.name<<" "<<section.location<<std::endl<<std::endl;
-          // std::cout<<object_file_name<<" "<<r->symbol_name<<" "<<r->location<<" "<<section.section_code.size()<<std::endl;
-          
-          section.section_code[r->location] = ((symbol_val & 0xFF000000) >> 3*8);
-          section.section_code[r->location + 1] = ((symbol_val & 0x00FF0000) >> 2*8);
-          section.section_code[r->location + 2] = ((symbol_val & 0x0000FF00) >> 1*8);
-          section.section_code[r->location + 3] = symbol_val & 0x000000FF;
-        }
+  for (std::string object_file_name : this->object_files_order){
+    Object_file* object_file = &this->object_files.at(object_file_name);
 
-      }
+    for(auto it: object_file->symbol_table.table){
+      Symbol* symbol = it.second;
+      if(!symbol->defined || symbol->is_section()) continue;
 
+      uint32_t address = symbol->value + object_file->sections.at(symbol->section_name).location;
+      symbols.push_back({address, symbol->name + " " + object_file_name});
     }
   }
 
+  std::stable_sort(symbols.begin(), symbols.end(),
+    [](const std::pair<uint32_t, std::string>& a, const std::pair<uint32_t, std::string>& b){ return a.first < b.first; });
+
+  std::ofstream map_file(this->map_file_name);
+  if(!map_file.is_open()) throw FileNameError(this->map_file_name);
+
+  for(auto& symbol : symbols)
+    map_file << "0x" << std::hex << std::setw(8) << std::setfill('0') << symbol.first << " " << symbol.second << "\n";
 }
 
 
-void Linker::write_output_file(std::ofstream& output_file){
-  
-  for(auto it : this->output_sections_order)
-    this->output_sections.at(it)->hex_output(output_file); 
+void Linker::write_output_file(OutputWriter& output_file){
   
+  for(auto it : this->output_sections_order){
+    Section* section = this->output_sections.at(it);
+    this->output_offsets[it] = output_file.offset();
+    output_file.write_hex(section->location, section->section_code);
+  }
 
-  // for (std::string object_file_name : this->object_files_order){
-  //   Object_file* object_file = &this->object_files.at(object_file_name);
-  //   for(auto it: object_file->sections){
-      
-  //   }
-  // }
+}
+
+
+//Sections are laid out into guest pages, pages are written as a PagedImage
+void Linker::write_binary_output_file(OutputWriter& output_file){
+  std::map<uint32_t, std::vector<uint8_t>> pages;
+
+  for(auto it : this->output_sections_order){
+    Section* section = this->output_sections.at(it);
+
+    for(size_t i = 0; i < section->section_code.size(); i++){
+      uint32_t address = section->location + i;
+      std::vector<uint8_t>& page = pages[address / PagedImage::page_size];
+      if(page.empty()) page.resize(PagedImage::page_size, 0);
+
+      page[address % PagedImage::page_size] = section->section_code[i];
+    }
+  }
+
+  uint64_t pages_offset = output_file.write_paged_image(pages);
+
+  //Pages of one section are consecutive in the file
+  for(auto it : this->output_sections_order){
+    Section* section = this->output_sections.at(it);
+    if(section->section_code.empty()) continue;
+
+    uint64_t page_index = std::distance(pages.begin(), pages.find(section->location / PagedImage::page_size));
+    this->output_offsets[it] = pages_offset + page_index * PagedImage::page_size + section->location % PagedImage::page_size;
+  }
+}
+
+
+std::string Linker::output_format(){
+  if(this->hex_option) return "hex";
+  if(this->binary_option) return "binary";
+  return "none";
+}
+
+
+void Linker::save_link_state(std::vector<std::string> input_file_names, std::string output_file_name){
+  Link_state state;
+  state.output_file_name = output_file_name;
+  state.output_format = this->output_format();
+  state.input_file_names = input_file_names;
+  state.section_places = this->requested_section_places;
+
+  for (std::string object_file_name : this->object_files_order){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+    state.object_hashes[object_file_name] = hash_file(object_file_name);
+
+    for(auto it: object_file->sections_order){
+      Section& section = object_file->sections.at(it);
+      auto offset = this->output_offsets.find(std::make_pair(section.name, object_file_name));
+
+      state.sections.push_back({object_file_name, section.name, section.location, (uint32_t)section.section_code.size(),
+        (offset != this->output_offsets.end()) ? offset->second : 0});
+    }
+
+    //Relocations of symbols defined in other files
+    for(auto it: object_file->relocation_table.table){
+      Relocation* relocation = it.second;
+      Symbol* symbol = object_file->symbol_table.get_symbol_by_name(relocation->symbol_name);
+      if(!symbol->defined)
+        state.imports.push_back({object_file_name, relocation->section_name, relocation->location, relocation->symbol_name});
+    }
+  }
+
+  for(auto& it: this->linker_symbol_table.table){
+    Symbol* symbol = it.second;
+    Symbol* section_symbol = this->linker_sections.at(std::make_pair(symbol->section_name, symbol->file_name));
+    state.symbols[symbol->name] = std::make_pair((uint32_t)(symbol->value + section_symbol->value), symbol->file_name);
+  }
+
+  state.save(this->state_file_name);
+}
+
+
+//Writes bytes of the section at position index directly into the existing output file
+void Linker::patch_output(std::FILE* output_file, const Link_state::Section_slot& slot, size_t index, const std::vector<uint8_t>& bytes){
+  if(this->hex_option){
+    const char digits[] = "0123456789ABCDEF";
+    for(size_t i = 0; i < bytes.size(); i++){
+      char hex[2] = {digits[bytes[i] >> 4], digits[bytes[i] & 0x0F]};
+      std::fseek(output_file, slot.output_offset + OutputWriter::hex_byte_offset(slot.location, index + i), SEEK_SET);
+      if(std::fwrite(hex, 1, 2, output_file) != 2) throw OutputWriteError();
+    }
+  }
+  else if(this->binary_option){
+    std::fseek(output_file, slot.output_offset + index, SEEK_SET);
+    if(std::fwrite(bytes.data(), 1, bytes.size(), output_file) != bytes.size()) throw OutputWriteError();
+  }
+}
+
+
+//Relinks only the object files that changed since the last link, reusing the previous layout.
+//Returns false when the layout can not be reused: different inputs or options, changed set of sections
+//or global symbols, or a section that outgrew its slot.
+bool Linker::incremental_link(std::vector<std::string> input_file_names, std::string output_file_name){
+  Link_state state;
+  if(!state.load(this->state_file_name)) return false;
+
+  if(state.output_file_name != output_file_name || state.output_format != this->output_format()
+    || state.input_file_names != input_file_names || state.section_places != this->requested_section_places)
+    return false;
+
+  if(!std::ifstream(output_file_name).good()) return false;
+
+  std::vector<std::string> changed_files;
+  for(std::string file_name : input_file_names){
+    uint64_t hash = hash_file(file_name);
+    if(hash != state.object_hashes.at(file_name)) changed_files.push_back(file_name);
+    state.object_hashes[file_name] = hash;
+  }
+
+  this->log_file << "Incremental link, changed files: " << changed_files.size() << "\n";
+  if(changed_files.empty()) return true;
+
+  this->decompose_input_files(changed_files);
+
+
+  //Changed objects go back into their previous slots
+  std::map<std::string, uint32_t> moved_symbols;
+  for(std::string object_file_name : changed_files){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+
+    std::vector<std::string> previous_sections;
+    for(auto& slot : state.sections)
+      if(slot.file_name == object_file_name) previous_sections.push_back(slot.section_name);
+    if(previous_sections != object_file->sections_order) return false;
+
+    for(auto it: object_file->sections_order){
+      Section& section = object_file->sections.at(it);
+      Link_state::Section_slot* slot = state.get_slot(object_file_name, it);
+      if(section.section_code.size() > slot->size) return false;
+
+      section.location = slot->location;
+      section.placed = true;
+    }
+
+    //Set of global symbols must stay the same, their addresses may move
+    std::set<std::string> previous_globals, current_globals;
+    for(auto& symbol : state.symbols)
+      if(symbol.second.second == object_file_name) previous_globals.insert(symbol.first);
+
+    for(auto it: object_file->symbol_table.table){
+      Symbol* symbol = it.second;
+      if(!symbol->defined){
+        if(state.symbols.find(symbol->name) == state.symbols.end()) return false;
+        continue;
+      }
+      if(!symbol->is_global) continue;
+
+      current_globals.insert(symbol->name);
+      uint32_t address = symbol->value + object_file->sections.at(symbol->section_name).location;
+      auto previous = state.symbols.find(symbol->name);
+      if(previous != state.symbols.end() && previous->second.first != address) moved_symbols[symbol->name] = address;
+    }
+
+    if(previous_globals != current_globals) return false;
+  }
+
+  for(auto& symbol : moved_symbols)
+    state.symbols.at(symbol.first).first = symbol.second;
+
+
+  //Patching goes to a copy that replaces the output only when complete, a failed relink leaves the previous output
+  std::string patched_file_name = output_file_name + ".tmp";
+  std::ofstream patched_output(patched_file_name, std::ios::binary);
+  if(!patched_output.is_open()) throw FileNameError(patched_file_name);
+
+  try{
+    //Copying an empty stream sets failbit, outputs without a format are empty
+    std::ifstream previous_output(output_file_name, std::ios::binary);
+    if(previous_output.peek() != std::ifstream::traits_type::eof()) patched_output << previous_output.rdbuf();
+    patched_output.close();
+    if(!patched_output) throw OutputWriteError();
+
+    this->patch_relinked(changed_files, moved_symbols, state, patched_file_name);
+  }
+  catch(...){
+    std::remove(patched_file_name.c_str());
+    throw;
+  }
+
+  if(std::rename(patched_file_name.c_str(), output_file_name.c_str()) != 0){
+    //Renaming over an existing file fails on some hosts
+    std::remove(output_file_name.c_str());
+    if(std::rename(patched_file_name.c_str(), output_file_name.c_str()) != 0) throw OutputWriteError();
+  }
+
+  state.save(this->state_file_name);
+
+  return true;
+}
+
+
+//Relocates changed objects into their slots of the output copy, and patches the imports of moved symbols
+void Linker::patch_relinked(const std::vector<std::string>& changed_files, const std::map<std::string, uint32_t>& moved_symbols,
+  Link_state& state, const std::string& patched_file_name){
+  std::unique_ptr<std::FILE, int(*)(std::FILE*)> file(std::fopen(patched_file_name.c_str(), "r+b"), std::fclose);
+  if(!file) throw FileNameError(patched_file_name);
+  std::FILE* output_file = file.get();
+
+  //Relocate changed objects and rewrite their slots, the unused end of a slot is zero filled
+  std::vector<Link_state::Import_site> imports;
+  for(auto import : state.imports)
+    if(std::find(changed_files.begin(), changed_files.end(), import.file_name) == changed_files.end()) imports.push_back(import);
+
+  for(std::string object_file_name : changed_files){
+    Object_file* object_file = &this->object_files.at(object_file_name);
+
+    for(auto it: object_file->relocation_table.table){
+      Relocation* relocation = it.second;
+      Symbol* symbol = object_file->symbol_table.get_symbol_by_name(relocation->symbol_name);
+
+      uint32_t symbol_val;
+      if(symbol->defined) 
+        symbol_val = symbol->value + object_file->sections.at(symbol->section_name).location;
+      else{
+        symbol_val = state.symbols.at(symbol->name).first;
+        imports.push_back({object_file_name, relocation->section_name, relocation->location, relocation->symbol_name});
+      }
+
+      Section& section = object_file->sections.at(relocation->section_name);
+      patch_word(section.section_code, relocation->location, symbol_val);
+    }
+
+    for(auto it: object_file->sections_order){
+      Section& section = object_file->sections.at(it);
+      Link_state::Section_slot* slot = state.get_slot(object_file_name, it);
+
+      std::vector<uint8_t> code = section.section_code;
+      code.resize(slot->size, 0);
+      if(code.empty()) continue;
+
+      if(this->hex_option){
+        std::string text = OutputWriter::hex_text(slot->location, code);
+        std::fseek(output_file, slot->output_offset, SEEK_SET);
+        if(std::fwrite(text.data(), 1, text.size(), output_file) != text.size()) throw OutputWriteError();
+      }
+      else this->patch_output(output_file, *slot, 0, code);
+
+      this->log_file << "Relinked " << it << " (" << object_file_name << ")\n";
+    }
+  }
+
+  //Unchanged objects only need the relocations of moved symbols
+  for(auto& import : imports){
+    auto moved = moved_symbols.find(import.symbol_name);
+    if(moved == moved_symbols.end()) continue;
+    if(std::find(changed_files.begin(), changed_files.end(), import.file_name) != changed_files.end()) continue;
+
+    uint32_t symbol_val = moved->second;
+    std::vector<uint8_t> bytes = {
+      (uint8_t)((symbol_val & 0xFF000000) >> 3*8), (uint8_t)((symbol_val & 0x00FF0000) >> 2*8),
+      (uint8_t)((symbol_val & 0x0000FF00) >> 1*8), (uint8_t)(symbol_val & 0x000000FF)
+    };
+    this->patch_output(output_file, *state.get_slot(import.file_name, import.section_name), import.location, bytes);
+  }
+
+  state.imports = imports;
+
+  //Buffered writes fail at the latest when the file is closed
+  if(std::fclose(file.release()) != 0) throw OutputWriteError();
 }
 
 
@@ -477,17 +1011,56 @@ void Linker::write_output_file(std::ofstream& output_file){
 int main(int argc, char* argv[]) {
   try {
 
-    bool hex_option = false;
+    Linker_options options;
     std::regex input_file_regex(R"(^.*\.o$)");
+    std::regex library_file_regex(R"(^.*\.a$)");
     std::regex section_place_regex(R"(^\s*-place=(\w+)@(\d+|0x[0-9a-fA-F]+)\s*$)"); 
+    std::regex incremental_regex(R"(^--incremental=(.+)$)");
+    std::regex threads_regex(R"(^--threads=(\d+)$)");
+    std::regex map_regex(R"(^--map=(.+)$)");
     std::smatch match;
     std::vector<std::string> input_file_names;
     std::string output_file_name;
-    std::map<std::string, uint64_t> section_places;
     
     for(uint16_t i = 1; i < argc; i++){
       std::string token = argv[i];
 
+      //--icf
+      if (token == "--icf") {
+        options.icf_option = true;
+        continue;
+      }
+
+      //--incremental=state_file
+      if (regex_search(token, match, incremental_regex)) {
+        options.state_file_name = match[1];
+        continue;
+      }
+
+      //--no-log
+      if (token == "--no-log") {
+        options.log_option = false;
+        continue;
+      }
+
+      //--threads=N
+      if (regex_search(token, match, threads_regex)) {
+        options.thread_count = stoul(match[1]);
+        continue;
+      }
+
+      //--map=file
+      if (regex_search(token, match, map_regex)) {
+        options.map_file_name = match[1];
+        continue;
+      }
+
+      //-binary
+      if (token == "-binary") {
+        options.binary_option = true;
+        continue;
+      }
+
       //-o
       if (token.find("-o") != std::string::npos) {
         output_file_name = argv[++i];
@@ -496,7 +1069,7 @@ int main(int argc, char* argv[]) {
 
       //-hex
       if (token.find("-hex") != std::string::npos) {
-        hex_option = true;
+        options.hex_option = true;
         continue;
       }
 
@@ -505,14 +1078,19 @@ int main(int argc, char* argv[]) {
         continue;
       }
 
+      if (std::regex_search(token, library_file_regex)) {
+        options.library_file_names.push_back(token);
+        continue;
+      }
+
       if (regex_search(token, match, section_place_regex)) {
         
         std::string section_name = match[1];
         std::string location = match[2];
-        section_places.insert({section_name, stoull(location, nullptr, 0)});      //automatic base converting
+        options.section_places.insert({section_name, stoull(location, nullptr, 0)});      //automatic base converting
 
         //DEBUG INFO
-        // std::cout<<section_name<<" "<<section_places.at(section_name)<<std::endl;
+        // std::cout<<section_name<<" "<<options.section_places.at(section_name)<<std::endl;
 
         continue;
       }
@@ -522,8 +1100,12 @@ int main(int argc, char* argv[]) {
       throw InvalidLinkerCmdArgs(token);
     }
 
+    //Only one output format
+    if (options.hex_option && options.binary_option)
+      throw InvalidLinkerCmdArgs("");
+
 
-    Linker* linker = new Linker(hex_option, section_places);
+    Linker* linker = new Linker(options);
     linker->Link(input_file_names, output_file_name);
     delete linker;
 
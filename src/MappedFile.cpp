@@ -0,0 +1,86 @@
+#include "../inc/MappedFile.hpp"
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(const std::string& file_name, Mode mode): file_name(file_name), mode(mode){
+#ifndef _WIN32
+  int fd = open(file_name.c_str(), mode == SHARED ? O_RDWR : O_RDONLY);
+  if (fd < 0)
+    throw FileNameError(file_name);
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0){
+    close(fd);
+    throw FileNameError(file_name);
+  }
+
+  this->mapping_size = file_stat.st_size;
+  if (this->mapping_size > 0){
+    void* mapping = mmap(nullptr, this->mapping_size, mode == READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE, mode == SHARED ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED){
+      close(fd);
+      throw FileNameError(file_name);
+    }
+    this->mapping = static_cast<uint8_t*>(mapping);
+  }
+
+  close(fd);      //mapping stays valid
+#else
+  std::ifstream input_file(file_name, std::ios::binary);
+  if (!input_file.is_open())
+    throw FileNameError(file_name);
+
+  this->buffer.assign(std::istreambuf_iterator<char>(input_file), std::istreambuf_iterator<char>());
+  this->mapping = this->buffer.data();
+  this->mapping_size = this->buffer.size();
+#endif
+}
+
+#ifndef _WIN32
+MappedFile::MappedFile(int fd, size_t size, const std::string& name, Mode mode): file_name(name), mode(mode){
+  this->mapping_size = size;
+  if (size == 0) return;
+
+  void* mapping = mmap(nullptr, size, mode == READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED)
+    throw FileNameError(name);
+
+  this->mapping = static_cast<uint8_t*>(mapping);
+}
+#endif
+
+MappedFile::~MappedFile(){
+#ifndef _WIN32
+  if (this->mapping != nullptr) munmap(this->mapping, this->mapping_size);
+#else
+  if (this->mode == SHARED){
+    std::ofstream output_file(this->file_name, std::ios::binary);
+    output_file.write(reinterpret_cast<const char*>(this->buffer.data()), this->buffer.size());
+  }
+#endif
+}
+
+
+const uint8_t* MappedFile::data() const{
+  return this->mapping;
+}
+
+uint8_t* MappedFile::writable_data(){
+  return this->mode != READ_ONLY ? this->mapping : nullptr;
+}
+
+size_t MappedFile::size() const{
+  return this->mapping_size;
+}
+
+const std::string& MappedFile::name() const{
+  return this->file_name;
+}
@@ -0,0 +1,307 @@
+#include "../inc/Memory.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+
+//Guest words are big-endian
+static inline uint32_t guest_word(uint32_t word){
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return __builtin_bswap32(word);
+#else
+  return word;
+#endif
+}
+
+
+//Entries keep their tags in the low 5 bits
+static inline uint8_t* page_address(uintptr_t entry){
+  return reinterpret_cast<uint8_t*>(entry & ~(uintptr_t)31);
+}
+
+
+Memory::Memory(bool protection): protection(protection){
+  for (uint32_t i = 0; i < table_size; i++) this->directory[i].store(nullptr, std::memory_order_relaxed);
+}
+
+Memory::~Memory(){
+  for (uint8_t* page : this->owned_pages) free_page(page);
+  for (uint32_t i = 0; i < table_size; i++) delete[] this->directory[i].load(std::memory_order_relaxed);
+}
+
+
+//A permission bit is only set in entries of present pages, one test covers missing and denied
+uint8_t Memory::read_byte(uint32_t address){
+  uintptr_t entry = this->entry(address >> offset_bits);
+  if (!(entry & PAGE_READ)){
+    if (entry == 0 && !this->protection) return 0;
+    throw MemoryReadViolation(address);
+  }
+
+  return __atomic_load_n(page_address(entry) + (address & (page_size - 1)), __ATOMIC_RELAXED);
+}
+
+uint8_t Memory::fetch_byte(uint32_t address){
+  uintptr_t entry = this->entry(address >> offset_bits);
+  if (!(entry & PAGE_EXECUTE)){
+    if (entry == 0 && !this->protection) return 0;
+    throw MemoryExecuteViolation(address);
+  }
+
+  return __atomic_load_n(page_address(entry) + (address & (page_size - 1)), __ATOMIC_RELAXED);
+}
+
+//Stores into code pages tell the code listeners after the store, a core refilling its cache sees the new bytes
+void Memory::write_byte(uint32_t address, uint8_t value){
+  uintptr_t entry = this->writable_entry(address);
+  __atomic_store_n(page_address(entry) + (address & (page_size - 1)), value, __ATOMIC_RELAXED);
+  if (entry & code_tag) this->code_written(address, 1);
+}
+
+
+uint32_t Memory::read_word(uint32_t address){
+  if (address & 3)
+    return ((uint32_t)this->read_byte(address) << 24) | ((uint32_t)this->read_byte(address + 1) << 16)
+      | ((uint32_t)this->read_byte(address + 2) << 8) | this->read_byte(address + 3);
+
+  uintptr_t entry = this->entry(address >> offset_bits);
+  if (!(entry & PAGE_READ)){
+    if (entry == 0 && !this->protection) return 0;
+    throw MemoryReadViolation(address);
+  }
+
+  return guest_word(__atomic_load_n(reinterpret_cast<const uint32_t*>(page_address(entry) + (address & (page_size - 1))), __ATOMIC_RELAXED));
+}
+
+void Memory::write_word(uint32_t address, uint32_t value){
+  if (address & 3){
+    this->write_byte(address, value >> 24);
+    this->write_byte(address + 1, value >> 16);
+    this->write_byte(address + 2, value >> 8);
+    this->write_byte(address + 3, value);
+    return;
+  }
+
+  uintptr_t entry = this->writable_entry(address);
+  __atomic_store_n(reinterpret_cast<uint32_t*>(page_address(entry) + (address & (page_size - 1))), guest_word(value), __ATOMIC_RELAXED);
+  if (entry & code_tag) this->code_written(address, 4);
+}
+
+
+uint32_t Memory::compare_exchange_word(uint32_t address, uint32_t expected, uint32_t desired){
+  if (address & 3){
+    uint32_t value = this->read_word(address);
+    if (value == expected) this->write_word(address, desired);
+    return value;
+  }
+
+  uintptr_t entry = this->writable_entry(address);
+  if (!(entry & PAGE_READ))
+    throw MemoryReadViolation(address);
+
+  uint32_t* word = reinterpret_cast<uint32_t*>(page_address(entry) + (address & (page_size - 1)));
+  uint32_t value = guest_word(expected);
+  if (__atomic_compare_exchange_n(word, &value, guest_word(desired), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) && (entry & code_tag))
+    this->code_written(address, 4);
+
+  return guest_word(value);
+}
+
+
+//Missing pages of unprotected memory read as 0
+static const uint8_t zero_page[Memory::page_size] = {0};
+
+const uint8_t* Memory::read_span(uint32_t address){
+  uintptr_t entry = this->entry(address >> offset_bits);
+  if (!(entry & PAGE_READ)){
+    if (entry == 0 && !this->protection) return zero_page + (address & (page_size - 1));
+    throw MemoryReadViolation(address);
+  }
+
+  return page_address(entry) + (address & (page_size - 1));
+}
+
+//Size 0 only checks, and allocates a missing page
+void Memory::write_span(uint32_t address, const uint8_t* data, uint32_t size){
+  uintptr_t entry = this->writable_entry(address);
+  if (size == 0) return;
+
+  std::memcpy(page_address(entry) + (address & (page_size - 1)), data, size);
+  if (entry & code_tag) this->code_written(address, size);
+}
+
+
+Memory::Page_entry* Memory::table(uint32_t directory_index){
+  Page_entry* table = this->directory[directory_index].load(std::memory_order_acquire);
+  if (table != nullptr) return table;
+
+  Page_entry* new_table = new Page_entry[table_size];
+  for (uint32_t i = 0; i < table_size; i++) new_table[i].store(0, std::memory_order_relaxed);
+
+  //Another core may install the table first
+  if (this->directory[directory_index].compare_exchange_strong(table, new_table, std::memory_order_acq_rel))
+    return new_table;
+
+  delete[] new_table;
+  return table;
+}
+
+uintptr_t Memory::entry(uint32_t page_number) const{
+  Page_entry* table = this->directory[page_number >> table_bits].load(std::memory_order_acquire);
+  if (table == nullptr) return 0;
+
+  return table[page_number & (table_size - 1)].load(std::memory_order_acquire);
+}
+
+
+uint8_t* Memory::new_page(const uint8_t* contents){
+  void* page = nullptr;
+#ifndef _WIN32
+  if (posix_memalign(&page, page_size, page_size) != 0) throw std::bad_alloc();
+#else
+  page = _aligned_malloc(page_size, page_size);
+  if (page == nullptr) throw std::bad_alloc();
+#endif
+
+  if (contents != nullptr) std::memcpy(page, contents, page_size);
+  else std::memset(page, 0, page_size);
+  return static_cast<uint8_t*>(page);
+}
+
+void Memory::free_page(uint8_t* page){
+#ifndef _WIN32
+  std::free(page);
+#else
+  _aligned_free(page);
+#endif
+}
+
+
+//Fast path is one test on the entry, missing, shared and read-only pages fall through to the slow path
+uintptr_t Memory::writable_entry(uint32_t address){
+  Page_entry& slot = this->table(address >> (offset_bits + table_bits))[(address >> offset_bits) & (table_size - 1)];
+  uintptr_t entry = slot.load(std::memory_order_acquire);
+
+  while (true){
+    if ((entry & (PAGE_WRITE | shared_tag)) == PAGE_WRITE) return entry;
+
+    //Missing page, or first write to a shared page - copy it, a code page stays marked
+    uint8_t* page;
+    uintptr_t tags;
+    if (entry == 0){
+      if (this->protection) throw MemoryWriteViolation(address);
+      page = this->new_page(nullptr);
+      tags = PAGE_ALL;
+    }
+    else{
+      if (!(entry & PAGE_WRITE)) throw MemoryWriteViolation(address);
+      page = this->new_page(page_address(entry));
+      tags = entry & (PAGE_ALL | code_tag);
+    }
+
+    uintptr_t new_entry = reinterpret_cast<uintptr_t>(page) | tags;
+    if (slot.compare_exchange_strong(entry, new_entry, std::memory_order_acq_rel)){
+      std::lock_guard<std::mutex> lock(this->owned_pages_mutex);
+      this->owned_pages.push_back(page);
+      return new_entry;
+    }
+
+    //Another core changed the entry, entry holds its value
+    free_page(page);
+  }
+}
+
+void Memory::code_written(uint32_t address, uint32_t size){
+  for (Code_listener& listener : this->code_listeners) listener(address, size);
+}
+
+
+void Memory::protect(uint32_t page_number, uintptr_t permissions){
+  Page_entry& slot = this->table(page_number >> table_bits)[page_number & (table_size - 1)];
+  uintptr_t entry = slot.load(std::memory_order_acquire);
+
+  while (true){
+    if (entry != 0){
+      if (slot.compare_exchange_strong(entry, (entry & ~(uintptr_t)PAGE_ALL) | permissions, std::memory_order_acq_rel)) return;
+      continue;
+    }
+
+    uint8_t* page = this->new_page(nullptr);
+    if (slot.compare_exchange_strong(entry, reinterpret_cast<uintptr_t>(page) | permissions, std::memory_order_acq_rel)){
+      std::lock_guard<std::mutex> lock(this->owned_pages_mutex);
+      this->owned_pages.push_back(page);
+      return;
+    }
+    free_page(page);
+  }
+}
+
+const uint8_t* Memory::find_page(uint32_t page_number) const{
+  return page_address(this->entry(page_number));
+}
+
+//Data not aligned for the entry tags (hosts without mmap) is copied into an owned page
+void Memory::map_page(uint32_t page_number, uint8_t* data, uintptr_t permissions){
+  if (reinterpret_cast<uintptr_t>(data) & tag_mask){
+    this->own_copy(page_number, data, permissions);
+    return;
+  }
+
+  this->table(page_number >> table_bits)[page_number & (table_size - 1)].store(reinterpret_cast<uintptr_t>(data) | permissions, std::memory_order_release);
+}
+
+void Memory::share_page(uint32_t page_number, const uint8_t* data, uintptr_t permissions){
+  if (reinterpret_cast<uintptr_t>(data) & tag_mask){
+    this->own_copy(page_number, data, permissions);
+    return;
+  }
+
+  uintptr_t entry = reinterpret_cast<uintptr_t>(data) | permissions | shared_tag;
+  this->table(page_number >> table_bits)[page_number & (table_size - 1)].store(entry, std::memory_order_release);
+}
+
+
+void Memory::own_copy(uint32_t page_number, const uint8_t* data, uintptr_t permissions){
+  uint8_t* page = this->new_page(data);
+  {
+    std::lock_guard<std::mutex> lock(this->owned_pages_mutex);
+    this->owned_pages.push_back(page);
+  }
+  this->table(page_number >> table_bits)[page_number & (table_size - 1)].store(reinterpret_cast<uintptr_t>(page) | permissions, std::memory_order_release);
+}
+
+
+void Memory::add_code_listener(Code_listener listener){
+  this->code_listeners.push_back(listener);
+}
+
+bool Memory::mark_code(uint32_t page_number){
+  Page_entry& slot = this->table(page_number >> table_bits)[page_number & (table_size - 1)];
+  uintptr_t entry = slot.load(std::memory_order_acquire);
+
+  while (entry != 0){
+    if (entry & code_tag) return true;
+    if (slot.compare_exchange_weak(entry, entry | code_tag, std::memory_order_acq_rel)) return true;
+  }
+
+  return false;
+}
+
+
+std::vector<uint32_t> Memory::page_numbers() const{
+  std::vector<uint32_t> numbers;
+
+  for (uint32_t i = 0; i < table_size; i++){
+    Page_entry* table = this->directory[i].load(std::memory_order_acquire);
+    if (table == nullptr) continue;
+
+    for (uint32_t j = 0; j < table_size; j++)
+      if (table[j].load(std::memory_order_relaxed) != 0) numbers.push_back((i << table_bits) | j);
+  }
+
+  return numbers;
+}
@@ -0,0 +1,44 @@
+#include "../inc/Mmu.hpp"
+
+
+Mmu::Mmu(Memory& memory): memory(memory){
+  this->flush();
+}
+
+
+void Mmu::set_base(uint32_t page_table_base){
+  this->page_table_base = page_table_base & ~page_mask;
+  this->flush();
+}
+
+uint32_t Mmu::base() const{
+  return this->page_table_base;
+}
+
+void Mmu::flush(){
+  for (auto& access_tlb : this->tlb)
+    for (auto& entry : access_tlb) entry.page_number = invalid_page;
+}
+
+
+//TLB miss: page walk in physical memory, the result is cached for this access type only
+uint32_t Mmu::walk(uint32_t address, Access access){
+  uint32_t page_number = address >> page_bits;
+  uint32_t frame = page_number << page_bits;
+
+  if (this->page_table_base != 0){
+    uint32_t directory_entry = this->memory.read_word(this->page_table_base + (page_number >> 10) * 4);
+    if (!(directory_entry & 1)) throw PageFault(address);
+
+    uint32_t table_entry = this->memory.read_word((directory_entry & ~page_mask) + (page_number & 0x3FF) * 4);
+    if (!(table_entry & 1) || !(table_entry & (2u << access))) throw PageFault(address);
+
+    frame = table_entry & ~page_mask;
+  }
+
+  Tlb_entry& entry = this->tlb[access][page_number & (tlb_size - 1)];
+  entry.page_number = page_number;
+  entry.frame = frame;
+
+  return frame | (address & page_mask);
+}
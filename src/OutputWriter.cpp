@@ -0,0 +1,194 @@
+#include "../inc/OutputWriter.hpp"
+#include <cstring>
+#include <algorithm>
+
+
+//"XX " for every byte value - one copy per formatted byte
+const char (&OutputWriter::hex_table())[256][3]{
+  static char table[256][3];
+  static bool initialized = [](){
+    const char digits[] = "0123456789ABCDEF";
+    for (int i = 0; i < 256; i++){
+      table[i][0] = digits[i >> 4];
+      table[i][1] = digits[i & 0x0F];
+      table[i][2] = ' ';
+    }
+    return true;
+  }();
+  (void)initialized;
+
+  return table;
+}
+
+
+OutputWriter::OutputWriter(const std::string& file_name, size_t buffer_size): buffer(buffer_size){
+  this->file = std::fopen(file_name.c_str(), "wb");
+  if (this->file == nullptr)
+    throw FileNameError(file_name);
+
+  std::setvbuf(this->file, nullptr, _IONBF, 0);     //buffering is done here
+}
+
+OutputWriter::~OutputWriter(){
+  try {
+    this->close();
+  }
+  catch(...) {}
+}
+
+
+void OutputWriter::flush(){
+  if (this->used == 0) return;
+
+  if (std::fwrite(this->buffer.data(), 1, this->used, this->file) != this->used)
+    throw OutputWriteError();
+
+  this->written += this->used;
+  this->used = 0;
+}
+
+void OutputWriter::close(){
+  if (this->file == nullptr) return;
+
+  this->flush();
+  std::fclose(this->file);
+  this->file = nullptr;
+}
+
+
+uint64_t OutputWriter::offset() const{
+  return this->written + this->used;
+}
+
+
+void OutputWriter::reserve(size_t size){
+  if (this->used + size > this->buffer.size()) this->flush();
+}
+
+
+void OutputWriter::write_bytes(const void* data, size_t size){
+  //Big blocks go straight to the file
+  if (size >= this->buffer.size()){
+    this->flush();
+    if (std::fwrite(data, 1, size, this->file) != size)
+      throw OutputWriteError();
+    this->written += size;
+    return;
+  }
+
+  this->reserve(size);
+  std::memcpy(this->buffer.data() + this->used, data, size);
+  this->used += size;
+}
+
+
+void OutputWriter::write_word(uint32_t word){
+  uint8_t bytes[4] = {
+    static_cast<uint8_t>(word & 0xFF), static_cast<uint8_t>((word >> 8) & 0xFF),
+    static_cast<uint8_t>((word >> 16) & 0xFF), static_cast<uint8_t>((word >> 24) & 0xFF)
+  };
+  this->write_bytes(bytes, 4);
+}
+
+
+//Number of hex digits of a row address, at least 4
+size_t OutputWriter::address_width(uint32_t address){
+  size_t width = 4;
+  while (width < 8 && (address >> (4 * width)) != 0) width++;
+  return width;
+}
+
+
+//One row of the hex output: "\nADDRESS: XX XX XX XX XX XX XX XX ", returns number of characters written
+size_t OutputWriter::format_hex_row(char* out, uint32_t address, const uint8_t* bytes, size_t count){
+  const char (&table)[256][3] = hex_table();
+  char* start = out;
+
+  *out++ = '\n';
+  for (size_t digit = address_width(address); digit > 0; digit--)
+    *out++ = "0123456789ABCDEF"[(address >> (4 * (digit - 1))) & 0x0F];
+  *out++ = ':';
+  *out++ = ' ';
+
+  for (size_t i = 0; i < count; i++){
+    std::memcpy(out, table[bytes[i]], 3);
+    out += 3;
+  }
+
+  return out - start;
+}
+
+
+//Same text format as the section hex dump: each row of 8 bytes starts on a new line with its address
+void OutputWriter::write_hex(uint32_t location, const std::vector<uint8_t>& code){
+  const size_t row_size = 1 + 8 + 2 + 8 * 3;       //longest row
+
+  for (size_t i = 0; i < code.size(); i += 8){
+    this->reserve(row_size);
+    this->used += format_hex_row(this->buffer.data() + this->used, location + i, code.data() + i, std::min<size_t>(8, code.size() - i));
+  }
+}
+
+
+std::string OutputWriter::hex_text(uint32_t location, const std::vector<uint8_t>& code){
+  std::string text;
+  char row[1 + 8 + 2 + 8 * 3];
+
+  for (size_t i = 0; i < code.size(); i += 8)
+    text.append(row, format_hex_row(row, location + i, code.data() + i, std::min<size_t>(8, code.size() - i)));
+
+  return text;
+}
+
+
+//Offset of the two hex digits of code[index] from the start of the section hex text
+uint64_t OutputWriter::hex_byte_offset(uint32_t location, size_t index){
+  const uint64_t row_bytes = 8 * 3;
+  size_t row = index / 8;
+  uint64_t offset = 0;
+
+  //Full rows before this one, grouped by address width
+  uint64_t first = location;
+  uint64_t last = (uint64_t)location + 8 * row;        //address of this row
+  for (size_t width = 4; width <= 8 && first < last; width++){
+    uint64_t limit = (width == 8) ? last : std::min<uint64_t>(last, (uint64_t)1 << (4 * width));
+    if (limit <= first) continue;
+
+    uint64_t rows = (limit - first + 7) / 8;
+    offset += rows * (1 + width + 2 + row_bytes);
+    first += rows * 8;
+  }
+
+  return offset + 1 + address_width(location + 8 * row) + 2 + 3 * (index % 8);
+}
+
+
+//pages: page number -> page contents (PagedImage::page_size bytes)
+//Returns the file offset of the first page
+uint64_t OutputWriter::write_paged_image(const std::map<uint32_t, std::vector<uint8_t>>& pages,
+  const std::vector<std::pair<uint32_t, uint32_t>>& state){
+
+  this->write_bytes(PagedImage::magic, 4);
+  this->write_word(PagedImage::version);
+  this->write_word(PagedImage::page_size);
+  this->write_word(pages.size());
+  this->write_word(state.size());
+
+  for (auto& word : state){
+    this->write_word(word.first);
+    this->write_word(word.second);
+  }
+
+  for (auto& page : pages)
+    this->write_word(page.first);
+
+  //Page contents start on a page boundary
+  std::vector<uint8_t> padding(PagedImage::page_size - this->offset() % PagedImage::page_size, 0);
+  if (padding.size() != PagedImage::page_size) this->write_bytes(padding.data(), padding.size());
+
+  uint64_t pages_offset = this->offset();
+  for (auto& page : pages)
+    this->write_bytes(page.second.data(), PagedImage::page_size);
+
+  return pages_offset;
+}
@@ -0,0 +1,129 @@
+#include "../inc/Profiler.hpp"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+
+Profiler::Profiler(const std::string& prefix, uint32_t entry_address): prefix(prefix){
+  this->nodes.push_back(Call_node(entry_address, 0));
+  this->nodes[0].calls = 1;
+}
+
+
+void Profiler::load_symbols(const std::string& map_file_name){
+  this->symbols.load(map_file_name);
+}
+
+
+void Profiler::call(uint32_t target){
+  Call_node& node = this->nodes[this->current];
+  auto child = node.children.find(target);
+
+  if (child == node.children.end()){
+    uint32_t index = this->nodes.size();
+    this->nodes[this->current].children[target] = index;
+    this->nodes.push_back(Call_node(target, this->current));
+    this->current = index;
+  }
+  else
+    this->current = child->second;
+
+  this->nodes[this->current].calls++;
+}
+
+//Unbalanced returns (longjmp like code) stay at the root
+void Profiler::ret(){
+  this->current = this->nodes[this->current].parent;
+}
+
+
+uint64_t Profiler::total_instructions(uint32_t node) const{
+  uint64_t total = this->nodes[node].instructions;
+  for (auto& child : this->nodes[node].children)
+    total += this->total_instructions(child.second);
+  return total;
+}
+
+
+void Profiler::write_call_tree(std::ostream& os, uint32_t node, int depth) const{
+  const Call_node& call_node = this->nodes[node];
+  os << std::string(depth * 2, ' ') << std::left << std::setw(std::max(1, 40 - depth * 2)) << this->symbols.function_name(call_node.function)
+    << std::right << std::dec << std::setw(12) << call_node.calls << std::setw(15) << call_node.instructions
+    << std::setw(15) << this->total_instructions(node) << "\n";
+
+  for (auto& child : call_node.children)
+    this->write_call_tree(os, child.second, depth + 1);
+}
+
+
+void Profiler::write_folded(std::ostream& os, uint32_t node, const std::string& path) const{
+  const Call_node& call_node = this->nodes[node];
+  std::string node_path = path.empty() ? this->symbols.function_name(call_node.function) : path + ";" + this->symbols.function_name(call_node.function);
+
+  if (call_node.instructions) os << node_path << " " << std::dec << call_node.instructions << "\n";
+
+  for (auto& child : call_node.children)
+    this->write_folded(os, child.second, node_path);
+}
+
+
+void Profiler::write(const std::map<uint8_t, std::string>& opcode_names){
+  std::ofstream report(this->prefix + ".report");
+  if (!report.is_open())
+    throw FileNameError(this->prefix + ".report");
+
+  uint64_t total = 0;
+  for (auto& pc : this->pc_counts) total += pc.second;
+
+  //Flat profile per function: pc counts grouped by the closest symbol below them
+  std::map<std::string, uint64_t> function_counts;
+  for (auto& pc : this->pc_counts)
+    function_counts[this->symbols.containing_symbol(pc.first)] += pc.second;
+
+  std::vector<std::pair<uint64_t, std::string>> functions;
+  for (auto& function : function_counts) functions.push_back({function.second, function.first});
+  std::sort(functions.rbegin(), functions.rend());
+
+  report << "Instructions executed: " << std::dec << total << "\n\n";
+
+  report << "Functions\n";
+  report << std::left << std::setw(40) << "Function" << std::right << std::setw(15) << "Instructions" << std::setw(10) << "%" << "\n";
+  for (auto& function : functions)
+    report << std::left << std::setw(40) << function.second << std::right << std::setw(15) << function.first
+      << std::setw(10) << std::fixed << std::setprecision(2) << 100.0 * function.first / total << "\n";
+
+  std::vector<std::pair<uint64_t, uint32_t>> pcs;
+  for (auto& pc : this->pc_counts) pcs.push_back({pc.second, pc.first});
+  std::sort(pcs.rbegin(), pcs.rend());
+
+  report << "\nInstructions by pc\n";
+  report << std::left << std::setw(12) << "Pc" << std::setw(40) << "Location" << std::right << std::setw(15) << "Count" << "\n";
+  for (auto& pc : pcs){
+    std::stringstream address;
+    address << "0x" << std::hex << std::setw(8) << std::setfill('0') << pc.second;
+    report << std::left << std::setw(12) << address.str() << std::setw(40) << this->symbols.symbolize(pc.second)
+      << std::right << std::dec << std::setw(15) << pc.first << "\n";
+  }
+
+  report << "\nOpcodes\n";
+  report << std::left << std::setw(12) << "Opcode" << std::setw(10) << "Name" << std::right << std::setw(15) << "Count" << "\n";
+  for (int op_code = 0; op_code < 256; op_code++){
+    if (!this->opcode_counts[op_code]) continue;
+
+    std::stringstream code;
+    code << "0x" << std::hex << std::setw(2) << std::setfill('0') << op_code;
+    auto name = opcode_names.find(op_code);
+    report << std::left << std::setw(12) << code.str() << std::setw(10) << (name != opcode_names.end() ? name->second : "?")
+      << std::right << std::dec << std::setw(15) << this->opcode_counts[op_code] << "\n";
+  }
+
+  report << "\nCall tree\n";
+  report << std::left << std::setw(40) << "Function" << std::right << std::setw(12) << "Calls" << std::setw(15) << "Self" << std::setw(15) << "Total" << "\n";
+  this->write_call_tree(report, 0, 0);
+
+  std::ofstream folded(this->prefix + ".folded");
+  if (!folded.is_open())
+    throw FileNameError(this->prefix + ".folded");
+
+  this->write_folded(folded, 0, "");
+}
@@ -5,6 +5,7 @@ std::unordered_map<Usage_type, std::string> Usage_type_name =
     {
         { Usage_type::SYMBOL, "SYMBOL"},
         { Usage_type::SYMBOL_INDIRECT, "SYMBOL_INDIRECT"},
+        { Usage_type::SYMBOL_JUMP, "SYMBOL_JUMP"},
         { Usage_type::NONE, "NONE"}
     };
 
@@ -12,6 +13,7 @@ std::unordered_map<std::string, Usage_type> Usage_name_type =
     {
         { "SYMBOL", Usage_type::SYMBOL},
         { "SYMBOL_INDIRECT", Usage_type::SYMBOL_INDIRECT},
+        { "SYMBOL_JUMP", Usage_type::SYMBOL_JUMP},
         { "NONE", Usage_type::NONE}
     };
 
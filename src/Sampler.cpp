@@ -0,0 +1,134 @@
+#include "../inc/Sampler.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/time.h>
+#endif
+
+
+static std::atomic<uint32_t>* sample_attention = nullptr;
+static uint32_t sample_attention_mask = 0;
+
+#ifndef _WIN32
+static struct sigaction previous_action;
+
+//Lock-free atomics are async-signal-safe
+static void sample_signal_handler(int){
+  if (sample_attention != nullptr) sample_attention->fetch_or(sample_attention_mask, std::memory_order_relaxed);
+}
+#endif
+
+
+Sampler::Sampler(const std::string& prefix, uint32_t interval_usec, uint32_t entry_address,
+  std::atomic<uint32_t>& attention, uint32_t attention_mask): prefix(prefix){
+
+  this->call(entry_address);
+
+  sample_attention = &attention;
+  sample_attention_mask = attention_mask;
+
+#ifndef _WIN32
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = sample_signal_handler;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, &previous_action);
+
+  //Profiling timer counts process cpu time, an idle host does not produce samples
+  struct itimerval timer;
+  timer.it_interval.tv_sec = interval_usec / 1000000;
+  timer.it_interval.tv_usec = interval_usec % 1000000;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  this->running = true;
+#endif
+}
+
+Sampler::~Sampler(){
+  this->stop();
+}
+
+
+void Sampler::stop(){
+  if (!this->running) return;
+
+#ifndef _WIN32
+  struct itimerval timer;
+  std::memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  sigaction(SIGPROF, &previous_action, nullptr);
+#endif
+
+  sample_attention = nullptr;
+  this->running = false;
+}
+
+
+void Sampler::load_symbols(const std::string& map_file_name){
+  this->symbols.load(map_file_name);
+}
+
+
+void Sampler::sample(uint32_t pc){
+  this->samples++;
+  this->pc_samples[pc]++;
+
+  uint64_t frame_count = std::min<uint64_t>(this->depth, backtrace_depth);
+  std::vector<uint32_t> stack;
+  for (uint64_t i = this->depth - frame_count; i < this->depth; i++)
+    stack.push_back(this->frames[i % shadow_stack_size]);
+
+  this->stack_samples[stack]++;
+}
+
+
+void Sampler::write(){
+  std::ofstream report(this->prefix + ".samples");
+  if (!report.is_open())
+    throw FileNameError(this->prefix + ".samples");
+
+  std::map<std::string, uint64_t> function_samples;
+  for (auto& pc : this->pc_samples)
+    function_samples[this->symbols.containing_symbol(pc.first)] += pc.second;
+
+  std::vector<std::pair<uint64_t, std::string>> functions;
+  for (auto& function : function_samples) functions.push_back({function.second, function.first});
+  std::sort(functions.rbegin(), functions.rend());
+
+  report << "Samples: " << std::dec << this->samples << "\n\n";
+
+  report << "Functions\n";
+  report << std::left << std::setw(40) << "Function" << std::right << std::setw(12) << "Samples" << std::setw(10) << "%" << "\n";
+  for (auto& function : functions)
+    report << std::left << std::setw(40) << function.second << std::right << std::setw(12) << function.first
+      << std::setw(10) << std::fixed << std::setprecision(2) << 100.0 * function.first / this->samples << "\n";
+
+  std::vector<std::pair<uint64_t, uint32_t>> pcs;
+  for (auto& pc : this->pc_samples) pcs.push_back({pc.second, pc.first});
+  std::sort(pcs.rbegin(), pcs.rend());
+
+  report << "\nSamples by pc\n";
+  report << std::left << std::setw(12) << "Pc" << std::setw(40) << "Location" << std::right << std::setw(12) << "Samples" << "\n";
+  for (auto& pc : pcs){
+    std::stringstream address;
+    address << "0x" << std::hex << std::setw(8) << std::setfill('0') << pc.second;
+    report << std::left << std::setw(12) << address.str() << std::setw(40) << this->symbols.symbolize(pc.second)
+      << std::right << std::dec << std::setw(12) << pc.first << "\n";
+  }
+
+  std::ofstream folded(this->prefix + ".folded");
+  if (!folded.is_open())
+    throw FileNameError(this->prefix + ".folded");
+
+  for (auto& stack : this->stack_samples){
+    for (size_t i = 0; i < stack.first.size(); i++)
+      folded << (i ? ";" : "") << this->symbols.function_name(stack.first[i]);
+    folded << " " << std::dec << stack.second << "\n";
+  }
+}
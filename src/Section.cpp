@@ -12,19 +12,6 @@ std::ostream& operator<<(std::ostream& os, const Section& section) {
     return os << std::setfill(' ') << std::endl;
 }
 
-void Section::hex_output(std::ostream& os){
-  //Formatting options
-  int location_counter = this->location-8;
-
-  for (int i = 0; i < this->section_code.size(); i++){
-      if (i % 8 == 0)
-        os << std::uppercase << std::setfill('0') << std::setw(4) << std::right << std::hex <<std::endl<<(location_counter+=8)<<": ";
-
-      os << std::uppercase << std::setfill('0') << std::setw(2) << std::right << std::hex<< static_cast<uint32_t>(this->section_code[i]) << " ";
-  }
-
-}
-
 void Section::deserialize_line_section_code(Section& section, const std::string& line) {
     std::stringstream ss(line);
 
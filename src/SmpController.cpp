@@ -0,0 +1,43 @@
+#include "../inc/SmpController.hpp"
+
+
+SmpController::SmpController(uint32_t core_count, Interrupt_line interrupt_line)
+  : core_count(core_count), interrupt_line(interrupt_line), core_states(new std::atomic<uint8_t>[core_count]), awake_cores(core_count){
+  for (uint32_t i = 0; i < core_count; i++) this->core_states[i].store(AWAKE);
+}
+
+
+uint32_t SmpController::read(uint32_t core_id, uint32_t offset){
+  if (offset == 4) return core_id;
+  if (offset == 8) return this->core_count;
+
+  return 0;
+}
+
+void SmpController::write(uint32_t /*core_id*/, uint32_t offset, uint32_t value){
+  //IPIs to cores that do not exist are dropped
+  //The target counts as awake before the IPI is raised, so no core sees everyone parked in between
+  if (offset == 0 && value < this->core_count){
+    this->unpark(value);
+    this->interrupt_line(value, ipi_cause);
+  }
+}
+
+
+void SmpController::park(uint32_t core_id){
+  this->core_states[core_id].store(PARKED);
+  this->awake_cores.fetch_sub(1);
+}
+
+void SmpController::unpark(uint32_t core_id){
+  uint8_t parked = PARKED;
+  if (this->core_states[core_id].compare_exchange_strong(parked, AWAKE)) this->awake_cores.fetch_add(1);
+}
+
+void SmpController::stop(uint32_t core_id){
+  if (this->core_states[core_id].exchange(STOPPED) == AWAKE) this->awake_cores.fetch_sub(1);
+}
+
+bool SmpController::any_awake() const{
+  return this->awake_cores.load() != 0;
+}
@@ -0,0 +1,50 @@
+#include "../inc/SymbolMap.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+
+static std::string address_string(uint32_t address){
+  std::stringstream ss;
+  ss << "0x" << std::hex << std::setw(8) << std::setfill('0') << address;
+  return ss.str();
+}
+
+
+void SymbolMap::load(const std::string& map_file_name){
+  std::ifstream map_file(map_file_name);
+  if (!map_file.is_open())
+    throw FileNameError(map_file_name);
+
+  std::string line, address, name;
+  while (getline(map_file, line)){
+    std::stringstream ss(line);
+    if (!(ss >> address >> name)) continue;
+
+    //First label at an address names it
+    this->symbols.insert({(uint32_t)std::stoul(address, nullptr, 16), name});
+  }
+}
+
+
+std::string SymbolMap::symbolize(uint32_t address) const{
+  auto symbol = this->symbols.upper_bound(address);
+  if (symbol == this->symbols.begin()) return address_string(address);
+
+  symbol--;
+  std::stringstream ss;
+  ss << symbol->second;
+  if (address != symbol->first) ss << "+0x" << std::hex << address - symbol->first;
+  return ss.str();
+}
+
+//Call targets are function entries, only exact symbols are used as names
+std::string SymbolMap::function_name(uint32_t address) const{
+  auto symbol = this->symbols.find(address);
+  return symbol != this->symbols.end() ? symbol->second : address_string(address);
+}
+
+std::string SymbolMap::containing_symbol(uint32_t address) const{
+  auto symbol = this->symbols.upper_bound(address);
+  return symbol == this->symbols.begin() ? std::string("?") : (--symbol)->second;
+}
@@ -0,0 +1,59 @@
+#include "../inc/Terminal.hpp"
+#include "../inc/Timer.hpp"
+#include <cstdio>
+
+
+Terminal::Terminal(bool unbuffered): unbuffered(unbuffered){
+  this->buffer.reserve(buffer_size);
+}
+
+Terminal::~Terminal(){
+  this->flush();
+}
+
+
+uint32_t Terminal::read(uint32_t /*core_id*/, uint32_t /*offset*/){
+  return 0;
+}
+
+void Terminal::write(uint32_t /*core_id*/, uint32_t offset, uint32_t value){
+  if (offset != 0) return;
+  char character = value & 0xFF;
+
+  if (this->unbuffered){
+    std::fputc(character, stdout);
+    std::fflush(stdout);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->buffer_mutex);
+  this->buffer += character;
+  this->buffered.store(true, std::memory_order_relaxed);
+
+  if (character == '\n' || this->buffer.size() >= buffer_size) this->flush_locked();
+}
+
+
+//The first poll that sees buffered output starts its timeout
+void Terminal::flush_if_old(uint64_t now){
+  std::lock_guard<std::mutex> lock(this->buffer_mutex);
+
+  if (this->deadline == 0) this->deadline = now + flush_timeout_usec * Timer::cycles_per_usec;
+  else if (now >= this->deadline) this->flush_locked();
+}
+
+void Terminal::flush(){
+  std::lock_guard<std::mutex> lock(this->buffer_mutex);
+  this->flush_locked();
+}
+
+void Terminal::flush_locked(){
+  if (!this->buffer.empty()){
+    std::fwrite(this->buffer.data(), 1, this->buffer.size(), stdout);
+    std::fflush(stdout);
+    this->buffer.clear();
+  }
+
+  this->buffered.store(false, std::memory_order_relaxed);
+  this->deadline = 0;
+}
@@ -0,0 +1,140 @@
+#include "../inc/ThreadPool.hpp"
+#include <algorithm>
+
+
+//Pool and queue of the worker running on this thread
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local unsigned current_worker = 0;
+
+
+ThreadPool::ThreadPool(unsigned thread_count){
+  if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+  if (thread_count == 0) thread_count = 1;
+
+  for (unsigned i = 0; i < thread_count; i++)
+    this->queues.emplace_back(new Worker_queue());
+
+  for (unsigned i = 0; i < thread_count; i++)
+    this->workers.push_back(std::thread(&ThreadPool::worker_loop, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->task_available.notify_all();
+
+  for (auto& worker : this->workers)
+    worker.join();
+}
+
+
+void ThreadPool::submit(std::function<void()> task){
+  unsigned queue;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    queue = current_pool == this ? current_worker : this->next_queue++ % this->queues.size();
+    this->unfinished_tasks++;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->queues[queue]->mutex);
+    this->queues[queue]->tasks.push_back(task);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->queued_tasks++;
+  }
+  this->task_available.notify_one();
+}
+
+
+void ThreadPool::wait(){
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->all_done.wait(lock, [this]{ return this->unfinished_tasks == 0; });
+
+  if (this->first_exception){
+    std::exception_ptr e = this->first_exception;
+    this->first_exception = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+
+//Splits [0, count) into one contiguous chunk per worker and waits for all of them
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body){
+  if (count == 0) return;
+
+  size_t chunks = std::min(count, this->workers.size());
+  size_t chunk_size = (count + chunks - 1) / chunks;
+
+  for (size_t begin = 0; begin < count; begin += chunk_size){
+    size_t end = std::min(count, begin + chunk_size);
+    this->submit([begin, end, &body]{
+      for (size_t i = begin; i < end; i++) body(i);
+    });
+  }
+
+  this->wait();
+}
+
+
+unsigned ThreadPool::size() const{
+  return this->workers.size();
+}
+
+
+//Caller has reserved a task from queued_tasks, so one is in some queue: newest from its own queue, else steal the oldest
+std::function<void()> ThreadPool::take_task(unsigned worker){
+  while (true){
+    for (size_t i = 0; i < this->queues.size(); i++){
+      Worker_queue& queue = *this->queues[(worker + i) % this->queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) continue;
+
+      std::function<void()> task;
+      if (i == 0){
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+      }
+      else{
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+      }
+      return task;
+    }
+  }
+}
+
+
+void ThreadPool::worker_loop(unsigned worker){
+  current_pool = this;
+  current_worker = worker;
+
+  while (true){
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->task_available.wait(lock, [this]{ return this->stopping || this->queued_tasks > 0; });
+      if (this->stopping && this->queued_tasks == 0) return;
+
+      this->queued_tasks--;
+    }
+
+    std::function<void()> task = this->take_task(worker);
+
+    try {
+      task();
+    }
+    catch(...) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (!this->first_exception) this->first_exception = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (--this->unfinished_tasks == 0) this->all_done.notify_all();
+    }
+  }
+}
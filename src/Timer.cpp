@@ -0,0 +1,54 @@
+#include "../inc/Timer.hpp"
+
+
+static const uint64_t period_msec[8] = {500, 1000, 1500, 2000, 5000, 10000, 30000, 60000};
+
+
+uint32_t Timer::read(uint32_t /*core_id*/, uint32_t /*offset*/){
+  return this->configuration.load(std::memory_order_relaxed);
+}
+
+//Any core may write, core 0 starts the period at its next check
+void Timer::write(uint32_t /*core_id*/, uint32_t /*offset*/, uint32_t value){
+  this->configuration.store(value & 7, std::memory_order_relaxed);
+  this->restart.store(true, std::memory_order_release);
+  this->deadline.store(0, std::memory_order_release);
+}
+
+
+uint64_t Timer::period() const{
+  return period_msec[this->configuration.load(std::memory_order_relaxed)] * 1000 * cycles_per_usec;
+}
+
+
+bool Timer::tick(uint64_t now){
+  if (this->restart.exchange(false, std::memory_order_acquire)){
+    this->deadline.store(now + this->period(), std::memory_order_relaxed);
+    return false;
+  }
+
+  uint64_t deadline = this->deadline.load(std::memory_order_relaxed);
+  if (now < deadline) return false;
+
+  deadline += this->period();
+  if (deadline <= now) deadline = now + this->period();
+  this->deadline.store(deadline, std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t Timer::next_deadline() const{
+  if (this->restart.load(std::memory_order_acquire)) return 0;
+  return this->deadline.load(std::memory_order_relaxed);
+}
+
+
+uint32_t Timer::config() const{
+  return this->configuration.load(std::memory_order_relaxed);
+}
+
+//Deadline 0 is a period not started yet
+void Timer::restore(uint32_t config, uint64_t deadline){
+  this->configuration.store(config & 7, std::memory_order_relaxed);
+  this->restart.store(deadline == 0, std::memory_order_relaxed);
+  this->deadline.store(deadline, std::memory_order_relaxed);
+}